@@ -0,0 +1,114 @@
+#include "AxisProcessor.h"
+
+namespace
+{
+    constexpr int32_t Q15Max = INT16_MAX;
+
+    int16_t Saturate(int32_t value) { return Tiny::Math::Min(Tiny::Math::Max<int32_t>(value, INT16_MIN), Q15Max); }
+
+    /** Multiplies by a Q16 gain, rounded */
+    int32_t Scale(int32_t value, int32_t gain) { return static_cast<int32_t>((static_cast<int64_t>(value) * gain + (1 << 15)) >> 16); }
+
+    uint32_t SquareRoot(uint32_t value)
+    {
+        uint32_t root = 0;
+        for (uint32_t bit = 1u << 30; bit; bit >>= 2)
+        {
+            if (value >= root + bit)
+            {
+                value -= root + bit;
+                root = (root >> 1) + bit;
+            }
+            else root >>= 1;
+        }
+        return root;
+    }
+}
+
+void TinyCon::AxisProcessor::Configure(const AxisConfig& config)
+{
+    Config = config;
+    Inner = config.Deadzone << 7;
+    Outer = config.OuterDeadzone << 7;
+    DeadzoneGain = (static_cast<int64_t>(Q15Max) << 16) / Tiny::Math::Max<int32_t>(Q15Max - Inner - Outer, 1);
+
+    // y = x + (x^3 - x) * curve, sampled at the segment bounds, Shape interpolates in between
+    for (int8_t i = 0; i < CurvePoints; ++i)
+    {
+        const int32_t x = Tiny::Math::Min<int32_t>(i << CurveSegmentBits, Q15Max);
+        const int32_t cube = static_cast<int32_t>((static_cast<int64_t>(x) * x >> 15) * x >> 15);
+        Curve[i] = x + (cube - x) * config.Curve / 255;
+    }
+    // Both curves end at full scale, the cube just doesn't get there in Q15
+    Curve[CurvePoints - 1] = Q15Max;
+    if (!(config.Flags & AxisConfig::Calibrate)) Learned = false;
+}
+
+int16_t TinyCon::AxisProcessor::Calibrate(int16_t raw)
+{
+    int32_t value = raw;
+    if (Config.Flags & AxisConfig::Calibrate)
+    {
+        if (!Learned)
+        {
+            Learned = true;
+            Center = raw;
+            Min = Saturate(raw - InitialRange);
+            Max = Saturate(raw + InitialRange);
+            Filtered = 0;
+            UpdateGains();
+        }
+        else if (raw > Max || raw < Min)
+        {
+            Max = Tiny::Math::Max(Max, raw);
+            Min = Tiny::Math::Min(Min, raw);
+            UpdateGains();
+        }
+
+        const int32_t offset = raw - Center;
+        value = Scale(offset, offset >= 0 ? PositiveGain : NegativeGain);
+    }
+    if (Config.Flags & AxisConfig::Invert) value = -value;
+    return Saturate(value);
+}
+
+int16_t TinyCon::AxisProcessor::Shape(int16_t value, bool deadzone)
+{
+    int32_t magnitude = value < 0 ? -static_cast<int32_t>(value) : value;
+    if (deadzone) magnitude = ApplyDeadzone(magnitude);
+
+    // Piecewise linear between the curve points, the last point is one step past the Q15 range and taken at full scale
+    if (magnitude >= Q15Max) magnitude = Curve[CurvePoints - 1];
+    else
+    {
+        const auto segment = magnitude >> CurveSegmentBits;
+        const auto fraction = magnitude & ((1 << CurveSegmentBits) - 1);
+        magnitude = Curve[segment] + ((Curve[segment + 1] - Curve[segment]) * fraction >> CurveSegmentBits);
+    }
+    const int32_t shaped = value < 0 ? -magnitude : magnitude;
+
+    if (!Config.Filter) return Saturate(shaped);
+    Filtered += (shaped - Filtered) * (256 - Config.Filter) >> 8;
+    return Saturate(Filtered);
+}
+
+void TinyCon::AxisProcessor::ApplyRadialDeadzone(const AxisProcessor& x, int16_t& xValue, int16_t& yValue)
+{
+    const auto length = static_cast<int32_t>(SquareRoot(static_cast<uint32_t>(xValue * xValue) + static_cast<uint32_t>(yValue * yValue)));
+    if (!length) return;
+    const auto scaled = x.ApplyDeadzone(length);
+    xValue = Saturate(xValue * scaled / length);
+    yValue = Saturate(yValue * scaled / length);
+}
+
+void TinyCon::AxisProcessor::UpdateGains()
+{
+    PositiveGain = (static_cast<int64_t>(Q15Max) << 16) / Tiny::Math::Max<int32_t>(Max - Center, 1);
+    NegativeGain = (static_cast<int64_t>(Q15Max + 1) << 16) / Tiny::Math::Max<int32_t>(Center - Min, 1);
+}
+
+int32_t TinyCon::AxisProcessor::ApplyDeadzone(int32_t magnitude) const
+{
+    if (magnitude <= Inner) return 0;
+    return Tiny::Math::Min(Scale(magnitude - Inner, DeadzoneGain), Q15Max);
+}
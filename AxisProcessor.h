@@ -0,0 +1,81 @@
+#pragma once
+
+#include "Config.h"
+#include "Utilities.h"
+
+#include <Arduino.h>
+
+#include <array>
+#include <cstdint>
+
+namespace TinyCon
+{
+    /** Processing parameters of one axis, laid out like the AxisConfig register window */
+    struct AxisConfig
+    {
+        enum FlagBits : uint8_t { Calibrate = 1 << 0, Invert = 1 << 1, Radial = 1 << 2 };
+
+        uint8_t Flags = Calibrate;
+        // Fractions of full scale in 1/256, the inner one around the center, the outer one at both ends
+        uint8_t Deadzone = 8;
+        uint8_t OuterDeadzone = 0;
+        // Response curve, blends from linear at 0 to cubic at 255
+        uint8_t Curve = 0;
+        // Low-pass filter strength, 0 is off, each step keeps another 1/256 of the previous output
+        uint8_t Filter = 0;
+    };
+
+    /**
+     * Turns the raw reading of an axis into its reported value, all in Q15 fixed point, -32768 to 32767 for -1 to 1.
+     * The center is taken from the first sample and the range grows with the furthest sample seen to each side, then
+     * the deadzones, the response curve from a lookup table and the low-pass filter are applied. The radial deadzone of
+     * a stick needs both axis, so InputController runs it between Calibrate and Shape for axis pairs.
+     */
+    class AxisProcessor
+    {
+    public:
+        static constexpr int8_t CurveSegmentBits = 11;
+        static constexpr int8_t CurvePoints = (1 << (15 - CurveSegmentBits)) + 1;
+        // A freshly connected axis is assumed to reach at least this far from its center, until it went further
+        static constexpr int16_t InitialRange = 16384;
+
+        AxisProcessor() { Configure({}); }
+
+        void Configure(const AxisConfig& config);
+        [[nodiscard]] const AxisConfig& GetConfig() const { return Config; }
+        [[nodiscard]] bool IsRadial() const { return Config.Flags & AxisConfig::Radial; }
+        /** Forgets the learned center and range, the next sample becomes the center */
+        void ResetCalibration() { Learned = false; }
+
+        /** Center and range calibration, and inversion */
+        [[nodiscard]] int16_t Calibrate(int16_t raw);
+        /** The axial deadzones if asked to, the response curve and the filter */
+        [[nodiscard]] int16_t Shape(int16_t value, bool deadzone = true);
+        /** Applies the deadzones of the X axis config to the length of the stick vector instead of each axis */
+        static void ApplyRadialDeadzone(const AxisProcessor& x, int16_t& xValue, int16_t& yValue);
+
+        [[nodiscard]] int16_t GetCenter() const { return Center; }
+        [[nodiscard]] int16_t GetMin() const { return Min; }
+        [[nodiscard]] int16_t GetMax() const { return Max; }
+
+    private:
+        AxisConfig Config;
+        // Deadzone bounds in Q15 and the gain that stretches what is left in between back to full scale, in Q16
+        int32_t Inner = 0;
+        int32_t Outer = 0;
+        int32_t DeadzoneGain = 1 << 16;
+        std::array<int16_t, CurvePoints> Curve{};
+
+        bool Learned = false;
+        int16_t Center = 0;
+        int16_t Min = INT16_MIN;
+        int16_t Max = INT16_MAX;
+        // Gains of both sides of the center in Q16, only recalculated when the range grows
+        int32_t PositiveGain = 1 << 16;
+        int32_t NegativeGain = 1 << 16;
+        int32_t Filtered = 0;
+
+        void UpdateGains();
+        [[nodiscard]] int32_t ApplyDeadzone(int32_t magnitude) const;
+    };
+}
@@ -12,6 +12,10 @@ void TinyCon::BluetoothController::HapticWrite(uint16_t connection, BLECharacter
 
 void TinyCon::BluetoothController::Init()
 {
+    // The largest ATT MTU, so that a notification can carry all IMUs and not just the first 20 bytes
+    Bluefruit.configPrphBandwidth(BANDWIDTH_MAX);
+    Profile.AddReportFilter(GamepadFilter);
+    Profile.AddReportFilter(MpuFilter);
     Bluefruit.begin();
     Bluefruit.setTxPower(-40);
     Bluefruit.setName(TINYCON_PRODUCT);
@@ -26,7 +30,7 @@ void TinyCon::BluetoothController::Init()
     Bluefruit.Advertising.addService(MpuService);
     MpuCharacteristic.setProperties(CHR_PROPS_READ | CHR_PROPS_NOTIFY);
     MpuCharacteristic.setPermission(SECMODE_OPEN, SECMODE_NO_ACCESS);
-    MpuCharacteristic.setFixedLen(40);
+    MpuCharacteristic.setMaxLen(MpuEncoder::MaxSize);
     MpuCharacteristic.begin();
 
     HapticService.begin();
@@ -63,6 +67,10 @@ void TinyCon::BluetoothController::Update(uint32_t deltaTime)
         {
             Active = false;
             Connected = false;
+            MtuRequested = false;
+            GamepadFilter.Reset();
+            MpuFilter.Reset();
+            MpuEncoding.Reset();
             ForceAdvertise = false;
             AdvertisingStarted = false;
             Bluefruit.Advertising.stop();
@@ -126,22 +134,57 @@ void TinyCon::BluetoothController::Update(uint32_t deltaTime)
     }
     else if (Bluefruit.connected())
     {
-        Connected = true;
-
         LogBluetooth::Debug("Controller");
         ConnectionId = Bluefruit.connHandle();
-        auto report = Controller.MakeHidReport();
-        GamepadService.report(&report);
+        auto* connection = Bluefruit.Connection(ConnectionId);
+        // Centrals don't always ask for a larger MTU themselves, once per connection and no more than the SoftDevice
+        // was configured for
+        if (!MtuRequested && connection)
+        {
+            connection->requestMtuExchange(Tiny::Math::Min<uint16_t>(MpuEncoder::MaxSize + AttHeaderSize, BLE_GATT_ATT_MTU_MAX));
+            MtuRequested = true;
+        }
+        Connected = true;
+
+        // Every notification costs airtime on the next connection events, only changed reports go out
+        const auto time = millis();
+        uint32_t timestamp;
+        auto report = Controller.MakeHidReport(&timestamp);
+        if (GamepadFilter.IsDue(report, time) && GamepadService.report(&report))
+        {
+            GamepadFilter.Sent(report, time);
+            Profile.AddLatency(Profiler::Stages::BleInputLatency, timestamp, LastInputTimestamp);
+        }
 
         LogBluetooth::Debug(", MPU");
-        uint8_t data[GamepadController::MaxMpuControllers * 41];
-        std::size_t size = Controller.MakeMpuBuffer({data, sizeof(data)});
-        MpuCharacteristic.notify(data, size);
+        uint8_t data[MpuReportFilter::MaxSize];
+        std::size_t size = Controller.MakeMpuBuffer({data, sizeof(data)}, &timestamp);
+        const auto fields = Controller.GetMpuFields();
+        if (MpuFilter.IsDue({data, size}, fields, time))
+        {
+            // The filter always compares the half-float data, the host gets it in the format it selected, as many whole
+            // IMUs as the MTU less the ATT header leaves room for
+            uint8_t notification[MpuEncoder::MaxSize];
+            const std::size_t payload = connection ? connection->getMtu() - AttHeaderSize : BLE_GATT_ATT_MTU_DEFAULT - AttHeaderSize;
+            const auto length = MpuEncoding.Encode(Controller, {notification, Tiny::Math::Min(sizeof(notification), payload)});
+            if (MpuCharacteristic.notify(notification, length))
+            {
+                MpuFilter.Sent({data, size}, fields, time);
+                MpuEncoding.Sent();
+                if (size) Profile.AddLatency(Profiler::Stages::BleMpuLatency, timestamp, LastMpuTimestamp);
+            }
+        }
+        LogBluetooth::Debug(", Sent ", GamepadFilter.GetSentCount() + MpuFilter.GetSentCount(),
+                            ", Suppressed ", GamepadFilter.GetSuppressedCount() + MpuFilter.GetSuppressedCount());
     }
     else
     {
         LogBluetooth::Debug("Disconnected");
         ForceAdvertise = true;
+        MtuRequested = false;
+        GamepadFilter.Reset();
+        MpuFilter.Reset();
+        MpuEncoding.Reset();
     }
 
     LogBluetooth::Info(Tiny::TIEndl);
@@ -4,6 +4,9 @@
 
 #include "GamepadController.h"
 #include "CommandProcessor.h"
+#include "MpuEncoder.h"
+#include "Profiler.h"
+#include "ReportFilter.h"
 
 #include <functional>
 
@@ -13,7 +16,7 @@ namespace TinyCon
     class BluetoothController
     {
     public:
-        BluetoothController(GamepadController& controller, CommandProcessor& processor) {}
+        BluetoothController(GamepadController& controller, CommandProcessor& processor, Profiler& profile) {}
         void Init() {}
         void Update(uint32_t) {}
         void SetActive(bool) {}
@@ -27,8 +30,8 @@ namespace TinyCon
     class BluetoothController
     {
     public:
-        BluetoothController(const GamepadController& controller, CommandProcessor& processor)
-            : Controller(controller), Processor(processor) {}
+        BluetoothController(const GamepadController& controller, CommandProcessor& processor, Profiler& profile)
+            : Controller(controller), Processor(processor), Profile(profile) {}
 
         void Init();
         void Update(uint32_t deltaTime);
@@ -42,6 +45,8 @@ namespace TinyCon
         [[nodiscard]] bool IsActive() const { return Active || Connected; }
         [[nodiscard]] bool IsAdvertising() const { return ForceAdvertise || AdvertisingTimeout > 0; }
         [[nodiscard]] bool IsConnected() const { return Connected; }
+        [[nodiscard]] GamepadReportFilter& GetGamepadFilter() { return GamepadFilter; }
+        [[nodiscard]] MpuReportFilter& GetMpuFilter() { return MpuFilter; }
 
     private:
         static std::function<void(uint16_t, BLECharacteristic*, uint8_t*, uint16_t)> HapticWriteCallback;
@@ -49,6 +54,7 @@ namespace TinyCon
 
         bool Active = false;
         bool Connected = false;
+        bool MtuRequested = false;
 
         BLEDis Discovery;
         BLEHidGamepad GamepadService;
@@ -59,12 +65,19 @@ namespace TinyCon
         uint16_t ConnectionId = 0;
 
         constexpr static uint32_t AdvertisingTime = 40000;
+        constexpr static uint16_t AttHeaderSize = 3;
         int32_t AdvertisingTimeout = 0;
         bool ForceAdvertise = false;
         bool AdvertisingStarted = false;
+        uint32_t LastInputTimestamp = 0;
+        uint32_t LastMpuTimestamp = 0;
+        GamepadReportFilter GamepadFilter;
+        MpuReportFilter MpuFilter;
+        MpuEncoder MpuEncoding;
 
         const GamepadController& Controller;
         CommandProcessor& Processor;
+        Profiler& Profile;
     };
 #endif
 }
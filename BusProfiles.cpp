@@ -0,0 +1,43 @@
+#include "BusProfiles.h"
+
+#include "Storage.h"
+
+using LogI2C = Tiny::TILogTarget<TinyCon::I2CLogLevel>;
+
+const TinyCon::BusProfile& TinyCon::BusProfiles::Get(I2CAddress address) const
+{
+    for (int8_t i = 0; i < Count; ++i) if (Entries[i].Address == address) return Entries[i].Profile;
+    return Default;
+}
+
+void TinyCon::BusProfiles::Set(I2CAddress address, const BusProfile& profile)
+{
+    for (int8_t i = 0; i < Count; ++i)
+        if (Entries[i].Address == address)
+        {
+            Entries[i].Profile = profile;
+            return;
+        }
+
+    if (Count >= MaxProfiles)
+    {
+        LogI2C::Warning("I2C: No room for the profile of 0x", address, Tiny::TIFormat::Hex, Tiny::TIEndl);
+        return;
+    }
+    Entries[Count++] = {address, profile};
+}
+
+bool TinyCon::BusProfiles::Load()
+{
+    struct { int8_t Count; std::array<Entry, MaxProfiles> Entries; } stored{};
+    if (!Storage::Load(Path, Magic, &stored, sizeof(stored)) || stored.Count < 0 || stored.Count > MaxProfiles) return false;
+    Count = stored.Count;
+    Entries = stored.Entries;
+    return true;
+}
+
+bool TinyCon::BusProfiles::Save() const
+{
+    struct { int8_t Count; std::array<Entry, MaxProfiles> Entries; } stored{Count, Entries};
+    return Storage::Save(Path, Magic, &stored, sizeof(stored));
+}
@@ -0,0 +1,76 @@
+#pragma once
+
+#include "Config.h"
+
+#include <Arduino.h>
+
+#include <array>
+#include <cstdint>
+
+namespace TinyCon
+{
+    /**
+     * A device on I2C0, the 7 bit address with the channel of the mux it is behind above it. Devices on the bus itself
+     * have no channel, their address is the plain 7 bit address.
+     */
+    using I2CAddress = uint16_t;
+    static constexpr int8_t NoI2CChannel = -1;
+
+    constexpr I2CAddress MakeI2CAddress(uint8_t address, int8_t channel = NoI2CChannel) { return (channel + 1) << 8 | (address & 0x7F); }
+    constexpr uint8_t GetI2CBusAddress(I2CAddress address) { return address & 0x7F; }
+    constexpr int8_t GetI2CChannel(I2CAddress address) { return static_cast<int8_t>((address >> 8) - 1); }
+
+    struct BusProfile
+    {
+        uint32_t Clock = 400000;
+        // Per transaction, in us
+        uint16_t Timeout = 10000;
+        // Additional attempts of a failed queued transaction
+        uint8_t Retries = 1;
+        // Set once the clock was measured, or for devices that can't be measured and use a fixed clock
+        bool Calibrated = false;
+    };
+
+    /** A constant register read back at every candidate clock to find the fastest one that still works */
+    struct BusCalibration
+    {
+        static constexpr uint8_t MaxSize = 4;
+
+        I2CAddress Address = 0;
+        uint8_t Tx[2] = {};
+        uint8_t TxSize = 0;
+        uint8_t RxSize = 0;
+        // Time the device needs between the register select and the read, 0 to read with a repeated start
+        uint16_t Delay = 0;
+    };
+
+    /**
+     * Bus settings per device address, with the default profile for every device without one of its own. Calibrated
+     * profiles are persisted, so the calibration only runs the first time a device is seen.
+     */
+    class BusProfiles
+    {
+    public:
+        // Every pad and IMU, plus the display, the haptics and whatever else sits on the bus
+        static constexpr int8_t MaxProfiles = SeesawPadCount + MpuCount + 6;
+        static constexpr BusProfile Default{};
+
+        [[nodiscard]] const BusProfile& Get(I2CAddress address) const;
+        void Set(I2CAddress address, const BusProfile& profile);
+        bool Load();
+        bool Save() const;
+
+    private:
+        static constexpr const char* Path = "/busprofiles";
+        static constexpr uint32_t Magic = 0x42500002;
+
+        struct Entry
+        {
+            I2CAddress Address;
+            BusProfile Profile;
+        };
+
+        std::array<Entry, MaxProfiles> Entries{};
+        int8_t Count = 0;
+    };
+}
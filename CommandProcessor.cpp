@@ -1,5 +1,7 @@
 #include "CommandProcessor.h"
 
+#include "ReportFilter.h"
+
 using LogCommand = Tiny::TILogTarget<TinyCon::CommandLogLevel>;
 
 void TinyCon::CommandProcessor::Init()
@@ -17,12 +19,11 @@ void TinyCon::CommandProcessor::Init()
     SetRegister(Tiny::Drivers::Input::TITinyConCommands::Magic, 1, Tiny::Drivers::Input::TITinyConMagic & 0xFF);
 
     // Initialize the configurable registers with the default settings
-    SetRegister(Tiny::Drivers::Input::TITinyConCommands::MPUDataEnable,
-                Controller.GetAccelerationEnabled() << 3 | Controller.GetAngularVelocityEnabled() << 2 |
-                Controller.GetOrientationEnabled() << 1 | Controller.GetTemperatureEnabled());
+    SetRegister(Tiny::Drivers::Input::TITinyConCommands::MPUDataEnable, Controller.GetMpuFields());
     SetRegister(Tiny::Drivers::Input::TITinyConCommands::FeatureEnable, GetI2CEnabled() << 2 | GetBLEEnabled() << 1 | GetUSBEnabled());
+    SetRegister(Tiny::Drivers::Input::TITinyConCommands::MpuFormat, static_cast<uint8_t>(Controller.GetMpuFormat()));
 
-    for (int8_t i = 0; i < GamepadController::MaxMpuControllers; ++i)
+    for (int8_t i = 0; i < GamepadController::MaxMpuControllers && i < MpuSlots; ++i)
         SetRegister(Tiny::Drivers::Input::TITinyConCommands::MpuConfig1, i,
                     static_cast<uint8_t>(Controller.GetAccelerometerRange(i)) << 4 | static_cast<uint8_t>(Controller.GetGyroscopeRange(i)));
 
@@ -48,36 +49,179 @@ void TinyCon::CommandProcessor::Update()
     // Because devices may be detected any time, we need to update the types registers every time with the data
     for (int8_t i = 0; i < GamepadController::MaxHapticControllers; ++i)
         SetRegister(Tiny::Drivers::Input::TITinyConCommands::HapticTypes, i, static_cast<uint8_t>(Controller.GetHapticType(i)));
-    for (int8_t i = 0; i < GamepadController::MaxInputControllers; ++i)
+    for (int8_t i = 0; i < GamepadController::MaxInputControllers && i < InputSlots; ++i)
         SetRegister(Tiny::Drivers::Input::TITinyConCommands::ControllerTypes, i, static_cast<uint8_t>(Controller.GetControllerType(i)));
-    for (int8_t i = 0; i < GamepadController::MaxMpuControllers; ++i)
+    for (int8_t i = 0; i < GamepadController::MaxMpuControllers && i < MpuSlots; ++i)
         SetRegister(Tiny::Drivers::Input::TITinyConCommands::MpuTypes, i, static_cast<uint8_t>(Controller.GetMpuType(i)));
 
-    SetRegister(Tiny::Drivers::Input::TITinyConCommands::AxisCount, Controller.GetAxisCount());
-    SetRegister(Tiny::Drivers::Input::TITinyConCommands::ButtonCount, Controller.GetButtonCount());
-    constexpr auto dataStart = static_cast<uint8_t>(Tiny::Drivers::Input::TITinyConCommands::Data);
-    auto dataOffset = Controller.MakeMpuBuffer({Registers.data() + dataStart, Registers.size() - dataStart});
+    const auto& frame = Controller.GetSnapshot();
+    SetRegister(Tiny::Drivers::Input::TITinyConCommands::ButtonCount, frame.ButtonCount);
+    InputTimestamp = frame.InputTimestamp;
+    // Delta needs the report before, which a register read doesn't have, the Data registers carry it as Raw
+    const Tiny::Collections::TIFixedSpan<uint8_t> data = {Registers.data() + DataStart, static_cast<std::size_t>(DataEnd - DataStart)};
+    auto dataOffset = Controller.GetMpuFormat() == Tiny::Drivers::Input::TITinyConMpuFormats::Half ? Controller.MakeMpuBuffer(data)
+                                                                                                  : Controller.MakeMpuRawBuffer(data);
+
+    for (int16_t i = 0; i < frame.ButtonCount && i < 32 && DataStart + dataOffset < DataEnd; i += 8)
+        SetRegister(Tiny::Drivers::Input::TITinyConCommands::Data, dataOffset++, static_cast<uint8_t>(frame.Buttons >> i));
+    // Only as many axis as fit are reported, the count tells the host where the data ends
+    const int16_t axisCount = Tiny::Math::Min<int16_t, int16_t>(frame.AxisCount, (DataEnd - DataStart - dataOffset) / 2);
+    SetRegister(Tiny::Drivers::Input::TITinyConCommands::AxisCount, axisCount);
+    for (int16_t i = 0; i < axisCount; ++i)
+    {
+        const auto axis = HalfFromQ15(frame.Axis[i]);
+        SetRegister(Tiny::Drivers::Input::TITinyConCommands::Data, dataOffset++, axis >> 8);
+        SetRegister(Tiny::Drivers::Input::TITinyConCommands::Data, dataOffset++, axis & 0xFF);
+    }
+
+    for (dataOffset += DataStart; dataOffset < DataEnd; ++dataOffset) Registers[dataOffset] = dataOffset & 0xFF;
+
+    UpdateProfile();
+    UpdateAxisConfig();
+}
+
+void TinyCon::CommandProcessor::UpdateProfile()
+{
+    if (ProfileStage >= Tiny::Drivers::Input::TITinyConProfileFilterBase)
+    {
+        UpdateReportFilterProfile();
+        return;
+    }
+    if (ProfileStage >= Tiny::Drivers::Input::TITinyConProfileTaskBase)
+    {
+        UpdateTaskProfile();
+        return;
+    }
+
+    constexpr auto profile = Tiny::Drivers::Input::TITinyConCommands::Profile;
+    SetRegister(profile, 1, Profiler::StageCount);
+    if (ProfileStage >= Profiler::StageCount)
+    {
+        SetRegister(profile, 0, 0xFF);
+        for (uint8_t i = 2; i < 14; ++i) SetRegister(profile, i, 0xFF);
+        return;
+    }
+
+    const auto stage = Profiler::Stages(ProfileStage);
+    const uint16_t min = Tiny::Math::Min(Profile.GetMin(stage), 0xFFFFu);
+    const uint16_t max = Tiny::Math::Min(Profile.GetMax(stage), 0xFFFFu);
+    const uint16_t mean = Tiny::Math::Min(Profile.GetMean(stage), 0xFFFFu);
+    SetRegister(profile, 0, ProfileStage);
+    SetRegister(profile, 2, min >> 8);
+    SetRegister(profile, 3, min & 0xFF);
+    SetRegister(profile, 4, max >> 8);
+    SetRegister(profile, 5, max & 0xFF);
+    SetRegister(profile, 6, mean >> 8);
+    SetRegister(profile, 7, mean & 0xFF);
+    for (int8_t i = 0; i < Profiler::BucketCount; ++i) SetRegister(profile, 8 + i, Profile.GetBucketShare(stage, i));
+}
+
+void TinyCon::CommandProcessor::UpdateTaskProfile()
+{
+    constexpr auto profile = Tiny::Drivers::Input::TITinyConCommands::Profile;
+    SetRegister(profile, 1, Tasks.GetTaskCount());
+    const auto index = ProfileStage - Tiny::Drivers::Input::TITinyConProfileTaskBase;
+    if (index >= Tasks.GetTaskCount())
+    {
+        SetRegister(profile, 0, 0xFF);
+        for (uint8_t i = 2; i < 14; ++i) SetRegister(profile, i, 0xFF);
+        return;
+    }
+
+    const auto& task = Tasks.GetTask(index);
+    const uint16_t max = Tiny::Math::Min(task.MaxDuration, 0xFFFFu);
+    SetRegister(profile, 0, ProfileStage);
+    for (uint8_t i = 0; i < 4; ++i)
+    {
+        SetRegister(profile, 2 + i, task.Runs >> (24 - 8 * i));
+        SetRegister(profile, 6 + i, task.Overruns >> (24 - 8 * i));
+    }
+    SetRegister(profile, 10, max >> 8);
+    SetRegister(profile, 11, max & 0xFF);
+    SetRegister(profile, 12, 0);
+    SetRegister(profile, 13, 0);
+}
 
-    uint8_t value = 0;
-    for (int8_t i = 0; i < Controller.GetButtonCount(); ++i)
+void TinyCon::CommandProcessor::UpdateReportFilterProfile()
+{
+    constexpr auto profile = Tiny::Drivers::Input::TITinyConCommands::Profile;
+    SetRegister(profile, 1, Profile.GetReportFilterCount());
+    const auto thresholds = ProfileStage >= Tiny::Drivers::Input::TITinyConProfileThresholdBase;
+    const auto index = ProfileStage - (thresholds ? Tiny::Drivers::Input::TITinyConProfileThresholdBase : Tiny::Drivers::Input::TITinyConProfileFilterBase);
+    if (index >= Profile.GetReportFilterCount())
     {
-        value |= Controller.GetButton(i) << (i & 7);
-        if ((i & 7) == 7)
+        SetRegister(profile, 0, 0xFF);
+        for (uint8_t i = 2; i < 14; ++i) SetRegister(profile, i, 0xFF);
+        return;
+    }
+
+    SetRegister(profile, 0, ProfileStage);
+    const auto* mpu = Profile.GetMpuFilter(index);
+    if (!thresholds)
+    {
+        const auto& filter = Profile.GetReportFilter(index);
+        for (uint8_t i = 0; i < 4; ++i)
         {
-            SetRegister(Tiny::Drivers::Input::TITinyConCommands::Data, dataOffset++, value);
-            value = 0;
+            SetRegister(profile, 2 + i, filter.GetSentCount() >> (24 - 8 * i));
+            SetRegister(profile, 6 + i, filter.GetSuppressedCount() >> (24 - 8 * i));
         }
+        SetRegister(profile, 10, filter.GetKeepAlive() >> 8);
+        SetRegister(profile, 11, filter.GetKeepAlive() & 0xFF);
+        SetRegister(profile, 12, mpu ? 1 : 0);
+        SetRegister(profile, 13, 0);
+        return;
+    }
+
+    for (uint8_t i = 2; i < 14; ++i) SetRegister(profile, i, 0xFF);
+    const auto setThreshold = [this](uint8_t offset, float value)
+    {
+        const auto half = Tiny::Math::HalfFromFloat(value);
+        SetRegister(profile, offset, half >> 8);
+        SetRegister(profile, offset + 1, half & 0xFF);
+    };
+    if (mpu)
+    {
+        const auto& limits = mpu->GetThresholds();
+        setThreshold(2, limits.Acceleration);
+        setThreshold(4, limits.AngularVelocity);
+        setThreshold(6, limits.Orientation);
+        setThreshold(8, limits.Temperature);
+        setThreshold(10, limits.Quaternion);
     }
-    if (Controller.GetButtonCount() & 7) SetRegister(Tiny::Drivers::Input::TITinyConCommands::Data, dataOffset++, value);
-    for (auto i = 0; i < Controller.GetAxisCount(); ++i)
+#if !NO_BLE || !NO_USB
+    else setThreshold(2, Profile.GetGamepadFilter(index)->GetAxisThreshold());
+#endif
+}
+
+void TinyCon::CommandProcessor::UpdateAxisConfig()
+{
+    constexpr auto axisConfig = Tiny::Drivers::Input::TITinyConCommands::AxisConfig;
+    SetRegister(axisConfig, 1, Controller.GetAxisCount());
+    const auto* processor = Controller.GetAxisProcessor(AxisConfigIndex);
+    if (!processor)
     {
-        auto axis = Tiny::Math::HalfFromFloat(Controller.GetAxis(i));
-        if ((axis >= 0x7c00 && axis < 0x8000) || (axis >= 0xfc00)) axis = 0x0000;
-        SetRegister(Tiny::Drivers::Input::TITinyConCommands::Data, dataOffset++, axis >> 8);
-        SetRegister(Tiny::Drivers::Input::TITinyConCommands::Data, dataOffset++, axis & 0xFF);
+        SetRegister(axisConfig, 0, 0xFF);
+        for (uint8_t i = 2; i < 14; ++i) SetRegister(axisConfig, i, 0xFF);
+        return;
     }
 
-    for (dataOffset += dataStart; dataOffset < Registers.size(); ++dataOffset) Registers[dataOffset] = dataOffset & 0xFF;
+    const auto& config = processor->GetConfig();
+    const uint16_t center = processor->GetCenter();
+    const uint16_t min = processor->GetMin();
+    const uint16_t max = processor->GetMax();
+    SetRegister(axisConfig, 0, AxisConfigIndex);
+    SetRegister(axisConfig, 2, config.Flags);
+    SetRegister(axisConfig, 3, config.Deadzone);
+    SetRegister(axisConfig, 4, config.OuterDeadzone);
+    SetRegister(axisConfig, 5, config.Curve);
+    SetRegister(axisConfig, 6, config.Filter);
+    SetRegister(axisConfig, 7, center >> 8);
+    SetRegister(axisConfig, 8, center & 0xFF);
+    SetRegister(axisConfig, 9, min >> 8);
+    SetRegister(axisConfig, 10, min & 0xFF);
+    SetRegister(axisConfig, 11, max >> 8);
+    SetRegister(axisConfig, 12, max & 0xFF);
+    SetRegister(axisConfig, 13, 0);
 }
 
 bool TinyCon::CommandProcessor::ProcessCommand(Tiny::Collections::TIFixedSpan<uint8_t> command)
@@ -156,13 +300,22 @@ bool TinyCon::CommandProcessor::ProcessCommand(Tiny::Collections::TIFixedSpan<ui
             else LastCommandStatus = Tiny::Drivers::Input::TITinyConCommandStatus::ErrorIncompleteCommand;
             break;
         case Tiny::Drivers::Input::TITinyConCommands::MPUDataEnable:
-            if (command.size() > 1)
+            if (command.size() > 1 && !DataFits(command[1], Controller.GetMpuFormat()))
+            {
+                LastParameter = {command[1]};
+                LastCommandStatus = Tiny::Drivers::Input::TITinyConCommandStatus::ErrorMpuDataTooLarge;
+                LogCommand::Error("EMDTL:", command[1], Tiny::TIFormat::Hex, Tiny::TIEndl);
+            }
+            else if (command.size() > 1)
             {
                 Controller.SetAccelerationEnabled((command[1] & 0x08) != 0);
                 Controller.SetAngularVelocityEnabled((command[1] & 0x04) != 0);
                 Controller.SetOrientationEnabled((command[1] & 0x02) != 0);
                 Controller.SetTemperatureEnabled((command[1] & 0x01) != 0);
-                Registers[reg] = command[1];
+                Controller.SetQuaternionEnabled((command[1] & 0x10) != 0);
+                Controller.SetTimestampEnabled((command[1] & 0x20) != 0);
+                Controller.SetMagnetometerCountEnabled((command[1] & 0x40) != 0);
+                Registers[reg] = command[1] & 0x7F;
 
                 LastParameter = {command[1]};
                 LastCommandStatus = Tiny::Drivers::Input::TITinyConCommandStatus::Ok;
@@ -316,6 +469,78 @@ bool TinyCon::CommandProcessor::ProcessCommand(Tiny::Collections::TIFixedSpan<ui
             }
             else LastCommandStatus = Tiny::Drivers::Input::TITinyConCommandStatus::ErrorIncompleteCommand;
             break;
+        case Tiny::Drivers::Input::TITinyConCommands::Profile:
+            if (command.size() > 1)
+            {
+                ProfileStage = command[1];
+                if (command.size() > 2 && command[2] == Tiny::Drivers::Input::TITinyConResetConfirm)
+                {
+                    Profile.Reset();
+                    Profile.ResetReportFilters();
+                    Tasks.ResetStatistics();
+                }
+                UpdateProfile();
+
+                LastParameter = {command[1]};
+                LastCommandStatus = Tiny::Drivers::Input::TITinyConCommandStatus::Ok;
+                LogCommand::Debug("PRF:", command[1], Tiny::TIEndl);
+            }
+            else LastCommandStatus = Tiny::Drivers::Input::TITinyConCommandStatus::ErrorIncompleteCommand;
+            break;
+        case Tiny::Drivers::Input::TITinyConCommands::MpuFormat:
+            if (command.size() > 1)
+            {
+                if (command[1] > static_cast<uint8_t>(Tiny::Drivers::Input::TITinyConMpuFormats::Delta))
+                {
+                    LastCommandStatus = Tiny::Drivers::Input::TITinyConCommandStatus::ErrorInvalidMpuFormat;
+                    LogCommand::Error("EIMF:", command[1], Tiny::TIEndl);
+                }
+                else if (!DataFits(Controller.GetMpuFields(), Tiny::Drivers::Input::TITinyConMpuFormats(command[1])))
+                {
+                    LastCommandStatus = Tiny::Drivers::Input::TITinyConCommandStatus::ErrorMpuDataTooLarge;
+                    LogCommand::Error("EMDTL:", command[1], Tiny::TIEndl);
+                }
+                else
+                {
+                    Controller.SetMpuFormat(Tiny::Drivers::Input::TITinyConMpuFormats(command[1]));
+                    Registers[reg] = command[1];
+
+                    LastCommandStatus = Tiny::Drivers::Input::TITinyConCommandStatus::Ok;
+                    LogCommand::Debug("MPUFMT:", command[1], Tiny::TIEndl);
+                }
+
+                LastParameter = {command[1]};
+            }
+            else LastCommandStatus = Tiny::Drivers::Input::TITinyConCommandStatus::ErrorIncompleteCommand;
+            break;
+        case Tiny::Drivers::Input::TITinyConCommands::AxisConfig:
+            if (command.size() > 1)
+            {
+                AxisConfigIndex = command[1];
+                auto* processor = Controller.GetAxisProcessor(AxisConfigIndex);
+                if (!processor)
+                {
+                    LastCommandStatus = Tiny::Drivers::Input::TITinyConCommandStatus::ErrorInvalidAxisIndex;
+                    LogCommand::Error("EIAI:", command[1], Tiny::TIEndl);
+                }
+                else if (command.size() > 6)
+                {
+                    processor->Configure({static_cast<uint8_t>(command[2] & 0x7F), command[3], command[4], command[5], command[6]});
+                    if (command[2] & 0x80) processor->ResetCalibration();
+                    LastCommandStatus = Tiny::Drivers::Input::TITinyConCommandStatus::Ok;
+                    LogCommand::Debug("AXCFG", command[1], ":", command[2], Tiny::TIFormat::Hex, Tiny::TIEndl);
+                }
+                else
+                {
+                    LastCommandStatus = Tiny::Drivers::Input::TITinyConCommandStatus::Ok;
+                    LogCommand::Debug("AX:", command[1], Tiny::TIEndl);
+                }
+                UpdateAxisConfig();
+
+                LastParameter = {command[1], command.size() > 2 ? command[2] : static_cast<uint8_t>(0)};
+            }
+            else LastCommandStatus = Tiny::Drivers::Input::TITinyConCommandStatus::ErrorIncompleteCommand;
+            break;
         default:
             LastCommandStatus = Tiny::Drivers::Input::TITinyConCommandStatus::ErrorInvalidCommand;
             break;
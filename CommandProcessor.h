@@ -4,6 +4,8 @@
 
 #include "GamepadController.h"
 #include "Power.h"
+#include "Profiler.h"
+#include "Scheduler.h"
 #include "Utilities.h"
 
 #include "Core/Drivers/Input/TITinyConTypes.h"
@@ -14,13 +16,53 @@ namespace TinyCon
 {
     class CommandProcessor
     {
-        static constexpr int16_t MaxRegisters = 0x42 + GamepadController::MaxMpuControllers * 20 + GamepadController::MaxInputControllers * (8 * 2 + 4);
+        static constexpr int16_t MaxRegisters = 0x100;
 
     public:
         constexpr static int8_t MaxCommandSize = 14;
+        static constexpr int16_t DataStart = static_cast<uint8_t>(Tiny::Drivers::Input::TITinyConCommands::Data);
+        // Everything from the profile window on are command windows, the controller data has to end before them
+        static constexpr int16_t DataEnd = static_cast<uint8_t>(Tiny::Drivers::Input::TITinyConCommands::Profile);
+        static_assert(static_cast<uint8_t>(Tiny::Drivers::Input::TITinyConCommands::AxisConfig) + MaxCommandSize <= MaxRegisters);
+        // The type windows only have room for so many devices, the ones behind a mux beyond that are used for the
+        // reports but are not visible in the registers, and neither is data past the end of the data window
+        static constexpr int8_t InputSlots = static_cast<uint8_t>(Tiny::Drivers::Input::TITinyConCommands::MpuTypes) -
+                                             static_cast<uint8_t>(Tiny::Drivers::Input::TITinyConCommands::ControllerTypes);
+        static constexpr int8_t MpuSlots = static_cast<uint8_t>(Tiny::Drivers::Input::TITinyConCommands::MpuConfig6) -
+                                           static_cast<uint8_t>(Tiny::Drivers::Input::TITinyConCommands::MpuConfig1) + 1;
+        // A USB MPU report has to fit the 64 byte endpoint with its id
+        static constexpr int16_t MaxMpuReportSize = 63;
 
-        explicit CommandProcessor(GamepadController& controller, const PowerController& power)
-            : Controller(controller), Power(power) {}
+        /** One MPU with the fields of MPUDataEnable, after the header byte of the Raw layout if it has one */
+        static constexpr int16_t MpuSize(uint8_t mpuFields, bool raw)
+        {
+            return (mpuFields & 0x08 ? 6 : 0) + (mpuFields & 0x04 ? 6 : 0) + (mpuFields & 0x02 ? 6 : 0) +
+                   (mpuFields & 0x01 ? 2 : 0) + (mpuFields & 0x10 ? 8 : 0) + (mpuFields & 0x20 ? MpuController::TimestampSize : 0) +
+                   (mpuFields & 0x40 ? MpuController::MagnetometerCountSize : 0) + (raw ? 1 : 0);
+        }
+        /** The Data registers with every pad and MPU present, they carry Raw for anything but Half */
+        static constexpr int16_t DataSize(uint8_t mpuFields, Tiny::Drivers::Input::TITinyConMpuFormats format)
+        {
+            const auto raw = format != Tiny::Drivers::Input::TITinyConMpuFormats::Half;
+            return GamepadController::MaxMpuControllers * MpuSize(mpuFields, raw) + GamepadController::MaxInputControllers * (8 * 2 + 4);
+        }
+        /** An MPU report with every MPU present, Delta keyframes have a header byte before the Raw data */
+        static constexpr int16_t MpuReportSize(uint8_t mpuFields, Tiny::Drivers::Input::TITinyConMpuFormats format)
+        {
+            const auto raw = format != Tiny::Drivers::Input::TITinyConMpuFormats::Half;
+            const auto delta = format == Tiny::Drivers::Input::TITinyConMpuFormats::Delta;
+            return GamepadController::MaxMpuControllers * MpuSize(mpuFields, raw) + (delta ? 1 : 0);
+        }
+        // Fields or formats that would push the axis of the last pad out of the window, or an IMU out of the reports,
+        // are refused. Behind a mux there never is room for everything anyway, only what fits is kept then.
+        static constexpr bool DataFits(uint8_t mpuFields, Tiny::Drivers::Input::TITinyConMpuFormats format)
+        {
+            return I2CMuxChannelCount > 0 ||
+                   (DataStart + DataSize(mpuFields, format) <= DataEnd && MpuReportSize(mpuFields, format) <= MaxMpuReportSize);
+        }
+
+        explicit CommandProcessor(GamepadController& controller, const PowerController& power, Profiler& profile, Scheduler& tasks)
+            : Controller(controller), Power(power), Profile(profile), Tasks(tasks) {}
 
         void Init();
         void Update();
@@ -32,6 +74,8 @@ namespace TinyCon
         void SetBLEEnabled(bool enabled) { BLEEnabled = enabled; }
         [[nodiscard]] bool GetUSBEnabled() const { return USBEnabled; }
         void SetUSBEnabled(bool enabled) { USBEnabled = enabled; }
+        /** Edge time of the most recent button change in the data registers */
+        [[nodiscard]] uint32_t GetInputTimestamp() const { return InputTimestamp; }
 
         std::array<uint8_t, MaxRegisters> Registers = {};
 
@@ -42,10 +86,15 @@ namespace TinyCon
     private:
         GamepadController& Controller;
         const PowerController& Power;
+        Profiler& Profile;
+        Scheduler& Tasks;
 
         bool I2CEnabled = true;
         bool USBEnabled = TinyConUSBEnabledByDefault;
         bool BLEEnabled = TinyConBLEEnabledByDefault;
+        uint8_t ProfileStage = 0;
+        uint8_t AxisConfigIndex = 0;
+        uint32_t InputTimestamp = 0;
 
         /**
          * Using a buffer here instead of just-in-time generation because we are using larger 32-bit MCUs
@@ -53,5 +102,12 @@ namespace TinyCon
          */
         void SetRegister(Tiny::Drivers::Input::TITinyConCommands command, uint8_t offset, uint8_t value) { Registers[static_cast<uint8_t>(command) + offset] = value; }
         void SetRegister(Tiny::Drivers::Input::TITinyConCommands command, uint8_t value) { SetRegister(command, 0, value); }
+        void UpdateProfile();
+        void UpdateTaskProfile();
+        void UpdateReportFilterProfile();
+        void UpdateAxisConfig();
     };
-}
\ No newline at end of file
+
+    // The default fields fit in any format, Delta is the longest
+    static_assert(CommandProcessor::DataFits(0x0F, Tiny::Drivers::Input::TITinyConMpuFormats::Delta));
+}
@@ -13,8 +13,78 @@ namespace TinyCon
     constexpr int MaxNativeAdcPinCount = 6;
     // 8 if using all 6 axis, 14 if we use all the axis pins for buttons
     constexpr int MaxNativeGpioPinCount = 14;
+    // Hardware oversampling of the native axis as a power of two, 0 to 8, each step doubles the conversion time
+    constexpr uint8_t NativeAdcOversampling = 0;
     constexpr int MaxI2CWriteBufferFill = SERIAL_BUFFER_SIZE;
 
+    // TCA9548A style multiplexer on I2C0 and the number of its channels in use, 0 without a mux. Every channel is a
+    // sub-bus with room for 4 Joy FeatherWings and 2 ICM20948, pads and IMUs fill the channels in order. Devices on
+    // I2C0 itself stay reachable whatever channel is selected, so they must not share an address with a channel device.
+    #ifndef TINYCON_I2C_MUX_CHANNELS
+    #define TINYCON_I2C_MUX_CHANNELS 0
+    #endif
+    constexpr uint8_t I2CMuxAddress = 0x70;
+    constexpr int8_t I2CMuxChannelCount = TINYCON_I2C_MUX_CHANNELS;
+    // Joy FeatherWings and ICM20948 on I2C0, all of them sized in at compile time
+    #ifndef TINYCON_SEESAW_PADS
+    #define TINYCON_SEESAW_PADS 4
+    #endif
+    #ifndef TINYCON_MPUS
+    #define TINYCON_MPUS 2
+    #endif
+    constexpr int8_t SeesawPadCount = TINYCON_SEESAW_PADS;
+    constexpr int8_t MpuCount = TINYCON_MPUS;
+    // The ICM20948 samples into its FIFO at 1100 / (1 + MpuSampleRateDivider) Hz, every MPU update drains what it took
+    constexpr uint8_t MpuSampleRateDivider = 1;
+    // Feather pins the INT line of each ICM20948 is wired to, or -1 if it is not connected. With the INT line wired,
+    // every sample is timestamped with the data ready interrupt it raised, otherwise the timestamps are derived from
+    // the time the FIFO was drained and the nominal sample rate, which drifts with the sensor's clock.
+    constexpr int8_t MpuInterruptPins[] = {-1, -1};
+    // Every FIFO sample also goes through a Mahony filter for the orientation quaternion. The proportional gain decides
+    // how fast gravity and the magnetic field pull it back, the integral gain how fast the gyroscope bias is learned, 0
+    // turns that off. Without the magnetometer the heading drifts, but nearby metal can't throw it off either.
+    constexpr float MpuFusionProportionalGain = 0.5f;
+    constexpr float MpuFusionIntegralGain = 0;
+    constexpr bool MpuFusionMagnetometer = true;
+    // The gyroscope bias is learned whenever an IMU lies still for MpuStillTime ms, that is its angular velocity and
+    // acceleration vary by less than these standard deviations in rad/s and m/s², a few times the sensor noise. It is
+    // kept in bins of MpuBiasTemperatureStep °C, persisted at most every MpuBiasSaveInterval ms unless a new
+    // temperature was learned, and subtracted from the angular velocity before anything else sees it.
+    constexpr bool MpuBiasLearning = true;
+    constexpr uint16_t MpuStillTime = 1000;
+    constexpr float MpuStillAngularVelocity = 0.01f;
+    constexpr float MpuStillAcceleration = 0.1f;
+    constexpr float MpuBiasMinTemperature = 0;
+    constexpr float MpuBiasTemperatureStep = 4;
+    constexpr uint32_t MpuBiasSaveInterval = 300000;
+
+    // Feather pins the INT line of each Joy FeatherWing is wired to, or -1 if it is not connected. With the INT line
+    // wired, buttons are only read when the Seesaw signals a change, while the axis are sampled at their own rate.
+    constexpr int8_t SeesawInterruptPins[] = {-1, -1, -1, -1};
+    // Samples a button has to be stable for, 1 to 7. Eager debouncing reports a press or release on its first sample
+    // and ignores the button for this many samples after, otherwise the change is only reported once it was stable.
+    constexpr uint8_t ButtonDebounceDepth = 3;
+    constexpr bool ButtonDebounceEager = true;
+    // Inputs are sampled InputOversampling times per report, and the samples of each axis are decimated into the value
+    // that is reported. Average takes out the noise, Peak holds the minimum or maximum, whichever is further from the
+    // center, so a flick of the stick between two reports still shows up. Latest reports the last sample as it is.
+    // Whatever the decimation, a button pressed at any sample is reported pressed in the next report.
+    enum class InputDecimations : uint8_t { Latest = 0, Average, Peak };
+    constexpr uint8_t InputOversampling = 2;
+    constexpr InputDecimations InputDecimation = InputDecimations::Average;
+    // USB and Bluetooth only send a report when it changed by more than these since the last one that went out, and
+    // at least every ReportKeepAlive ms otherwise. The axis threshold is in HID axis counts, the MPU thresholds are in
+    // the units of the MPU data, m/s², rad/s, uT, °C and quaternion components.
+    constexpr uint16_t ReportKeepAlive = 250;
+    constexpr uint8_t ReportAxisThreshold = 0;
+    constexpr float ReportAccelerationThreshold = 0.05f;
+    constexpr float ReportAngularVelocityThreshold = 0.01f;
+    constexpr float ReportOrientationThreshold = 0.5f;
+    constexpr float ReportTemperatureThreshold = 0.25f;
+    constexpr float ReportQuaternionThreshold = 0.002f;
+    // In the Delta MPU format, every this many reports sent is a keyframe, so a host that lost one catches up again
+    constexpr uint16_t MpuKeyframeInterval = 50;
+
     // Not the prettiest way to do logging for now, but should do the job
     constexpr Tiny::TILogLevel StateLogLevel = Tiny::TILogLevel::Warning;
     constexpr Tiny::TILogLevel BluetoothLogLevel = Tiny::TILogLevel::Warning;
@@ -25,6 +95,8 @@ namespace TinyCon
     constexpr Tiny::TILogLevel IndicatorLogLevel = Tiny::TILogLevel::Warning;
     constexpr Tiny::TILogLevel UsbLogLevel = Tiny::TILogLevel::Warning;
     constexpr Tiny::TILogLevel PowerLogLevel = Tiny::TILogLevel::Warning;
+    constexpr Tiny::TILogLevel SchedulerLogLevel = Tiny::TILogLevel::Warning;
+    constexpr Tiny::TILogLevel StorageLogLevel = Tiny::TILogLevel::Warning;
 
     #ifndef TINYCON_PRODUCT
     #define TINYCON_PRODUCT "TinyCon"
@@ -61,6 +133,13 @@ namespace TinyCon
     #define USE_LC709203 0
 #endif
 
+// Calibration data is kept in the internal flash through LittleFS where the core provides it
+#if defined(NRF52840_XXAA) || defined(NRF52832_XXAA)
+    #define USE_LITTLEFS 1
+#else
+    #define USE_LITTLEFS 0
+#endif
+
 #ifdef USE_TINYUSB
     #define NO_USB 0
 #else
@@ -99,7 +99,7 @@ namespace Tiny::Drivers::Input
         ButtonCount = 0x3D,
         /**
          * MPU features enable, 1 byte, read-write
-         * 0: [7-4:Reserved|3:AccelEn|2:GyroEn|1:MagEn|0:TempEn]
+         * 0: [7:Reserved|6:MagCountEn|5:TimeEn|4:QuatEn|3:AccelEn|2:GyroEn|1:MagEn|0:TempEn]
          */
         MPUDataEnable = 0x3E,
         /**
@@ -112,27 +112,103 @@ namespace Tiny::Drivers::Input
         Magic = 0x40,
 
         /**
-         * The controller data, containing all enabled MPUs before all buttons before all axis. If any of these are not
-         * present, they will be skipped. A current full read will be 20 * 2 MPU bytes + 1 * 2 button bytes + 2 * 2 * 2 axis
-         * bytes = 50 bytes in total. The maximum size is 20 * 8 MPU bytes + 4 * 8 button bytes + 2 * 8 * 8 axis bytes = 320
-         * bytes. Since this does not fit our 256 - 64 = 192 byte address space, we currently only support a subset of the
-         * available sensors. Reading requires one additional parameter for the page to read. A page is 192 bytes of
-         * controller data. The data is paged instead of organized by controller to make reads more efficient. The maximum
-         * number of pages is currently 2, starting with 0, as we only have 320 bytes of data at maximum. Read-only
-         *     MPUs up to 6 * 20 byte in half-float format
+         * The controller data, containing all enabled MPUs before all buttons before all axis, in the 0xE0 - 0x42 = 158
+         * bytes up to the Profile window. If any of these are not present, they will be skipped. MPUDataEnable and
+         * MpuFormat refuse MPU data that would not fit with every pad and MPU present, so nothing is cut off. Behind a
+         * mux there are more devices than the window has room for, only whole MPUs and as many axis as fit are kept
+         * then, AxisCount tells how many made it. The sizes below are those of the default config. Read-only
+         *     MPUs up to 2 * 34 byte in half-float format, or 2 * 35 byte as Raw for the Raw and Delta formats
          *          Accel 6 byte in half-float format, if enabled
          *          Gyro  6 byte in half-float format, if enabled
          *          Mag   6 byte in half-float format, if enabled
          *          Temp  2 byte in half-float format, if enabled
-         *     Buttons 0-32 byte in boolean array format with up to 256 buttons
-         *     Axis 0-64 * 2 byte in half-float format
+         *          Quat  8 byte in half-float format W, X, Y, Z, fused on the device, if enabled
+         *          Time  4 byte little-endian microseconds on the device's free-running clock, when the sample was
+         *                taken, if enabled
+         *          MagCount 2 byte little-endian count of magnetometer readings, wrapping, Mag only changed if it did,
+         *                   if enabled
+         *     Buttons 0-4 byte in boolean array format with up to 32 buttons
+         *     Axis 0-14 * 2 byte in half-float format
          */
-        Data = 0x42
+        Data = 0x42,
+
+        /**
+         * Profiling statistics for one firmware stage, 14 bytes. Writing the stage index selects the stage, the window
+         * is refreshed with the latest statistics until another stage is selected. Latency stages hold the time from a
+         * sample being acquired, or a button edge being seen, until the report containing it was handed to the
+         * transport. Writing TITinyConResetConfirm as a second parameter clears the statistics of all stages. Times are
+         * in us, unsigned 16 bit, saturated.
+         * 0: Stage index, see TITinyConProfileStages, 0xFF if invalid
+         * 1: Number of stages
+         * 2-3: Minimum duration
+         * 4-5: Maximum duration
+         * 6-7: Mean duration
+         * 8-13: Share of the samples per bucket in 1/255, the buckets are < 64us, < 256us, < 1ms, < 4ms, < 16ms and
+         *       >= 16ms
+         * Indices from TITinyConProfileTaskBase on select a scheduler task instead, in the order the firmware added
+         * them. Resetting clears these as well.
+         * 0: TITinyConProfileTaskBase + task index, 0xFF if invalid
+         * 1: Number of tasks
+         * 2-5: Runs, unsigned 32 bit
+         * 6-9: Overruns, runs that finished after their deadline, unsigned 32 bit
+         * 10-11: Maximum duration
+         * 12-13: Reserved
+         * Indices from TITinyConProfileFilterBase on select a USB or Bluetooth report filter, in the order the
+         * transports added them, USB before Bluetooth and the gamepad before the MPU filter. Resetting clears the
+         * counts as well.
+         * 0: TITinyConProfileFilterBase + filter index, 0xFF if invalid
+         * 1: Number of filters
+         * 2-5: Reports sent, unsigned 32 bit
+         * 6-9: Reports suppressed as unchanged, unsigned 32 bit
+         * 10-11: Keep-alive interval in ms
+         * 12: Kind, 0 gamepad and 1 MPU
+         * 13: Reserved
+         * Indices from TITinyConProfileThresholdBase on select the thresholds of the same filters instead, as
+         * half-floats, 0xFFFF for those the filter doesn't have.
+         * 0: TITinyConProfileThresholdBase + filter index, 0xFF if invalid
+         * 1: Number of filters
+         * 2-3: Axis threshold in HID axis counts for the gamepad, acceleration in m/s² for the MPU
+         * 4-5: Angular velocity in rad/s
+         * 6-7: Orientation in uT
+         * 8-9: Temperature in °C
+         * 10-11: Quaternion
+         * 12-13: Reserved
+         */
+        Profile = 0xE0,
+        /**
+         * Wire format of the MPU data in the reports, 1 byte, read-write, see TITinyConMpuFormats. Half-floats by
+         * default, Raw and Delta carry the sensor counts, Delta in fewer bytes. Reports only, the Data registers can be
+         * read at any time, so with Delta they carry the Raw format.
+         * 0: Format
+         */
+        MpuFormat = 0xEE,
+
+        /**
+         * Processing of one axis, 14 bytes. Writing the axis index selects the axis, the window is refreshed with its
+         * config and calibration until another axis is selected. Writing 5 more bytes after the index sets the config
+         * of bytes 2-6. Fractions are in 1/256 of full scale, the calibration is in Q15 of the raw reading, big endian.
+         * 0: Axis index, in the order of the data registers, 0xFF if invalid
+         * 1: Number of axis
+         * 2: Flags, bit 0 calibrate, bit 1 invert, bit 2 radial deadzone for the pair of this and the next axis, set on
+         *    the first axis of a pair. Writing bit 7 forgets the calibration, it reads back as 0
+         * 3: Deadzone around the center
+         * 4: Deadzone at both ends
+         * 5: Response curve, 0 is linear and 255 cubic
+         * 6: Low-pass filter, 0 is off
+         * 7-8: Learned center
+         * 9-10: Learned minimum
+         * 11-12: Learned maximum
+         * 13: Reserved
+         */
+        AxisConfig = 0xF0
     };
 
     static constexpr uint16_t TITinyConVersion = 1;
     static constexpr uint16_t TITinyConMagic = 0x5443;
     static constexpr uint8_t TITinyConResetConfirm = 0xA5;
+    static constexpr uint8_t TITinyConProfileTaskBase = 0x80;
+    static constexpr uint8_t TITinyConProfileFilterBase = 0xC0;
+    static constexpr uint8_t TITinyConProfileThresholdBase = 0xD0;
     static constexpr uint8_t TITinyConHapticClearConfirm = 0x5A;
 
     enum class TITinyConCommandStatus : uint8_t
@@ -147,11 +223,41 @@ namespace Tiny::Drivers::Input
         ErrorInvalidHapticController,
         ErrorInvalidHapticDataIndex,
         ErrorInvalidHapticClearConfirm,
-        WarningUnknownHapticController
+        WarningUnknownHapticController,
+        ErrorInvalidAxisIndex,
+        ErrorInvalidMpuFormat,
+        ErrorMpuDataTooLarge
     };
 
     static constexpr bool IsOk(TITinyConCommandStatus status) { return status == TITinyConCommandStatus::Ok; }
-    static constexpr bool IsError(TITinyConCommandStatus status) { return status > TITinyConCommandStatus::Ok && status < TITinyConCommandStatus::WarningUnknownHapticController; }
+    static constexpr bool IsError(TITinyConCommandStatus status) { return status > TITinyConCommandStatus::Ok && status != TITinyConCommandStatus::WarningUnknownHapticController; }
+
+    enum class TITinyConProfileStages : uint8_t
+    {
+        Mpu = 0,
+        // One update of each input, the Seesaw pads in order and the native pins last. That is exactly five in the
+        // default config, with more pads behind a mux Input5 is shared by the fifth pad and every input after it.
+        Input1,
+        Input2,
+        Input3,
+        Input4,
+        Input5,
+        Haptic,
+        Command,
+        UsbReport,
+        BleReport,
+        Display,
+        UsbInputLatency,
+        UsbMpuLatency,
+        BleInputLatency,
+        BleMpuLatency,
+        I2CInputLatency,
+        // Sleep between scheduler runs, the time awake in between and from a wake event to the firmware running again
+        Sleep,
+        Awake,
+        WakeLatency,
+        Count
+    };
 
     enum class TITinyConMpuTypes : uint8_t
     {
@@ -159,6 +265,24 @@ namespace Tiny::Drivers::Input
         ICM20948
     };
 
+    /**
+     * Half: every MPU as laid out in the Data registers.
+     * Raw: every MPU as a header byte [7-4:TITinyConGyroscopeRanges|3-0:TITinyConAccelerometerRanges], then the enabled
+     *     fields in the same order as 16 bit little-endian signed counts. Acceleration and angular velocity in counts of
+     *     their range, the angular velocity less the bias the device learned, the magnetic field in 0.15uT, temperature
+     *     as °C = counts / 333.87 + 21, the quaternion in Q14, the timestamp and magnetometer count as in the Half format.
+     * Delta: a header byte [7:Keyframe|6-0:Sequence], then for a keyframe the Raw format, otherwise for every 16 bit
+     *     value of the last keyframe, in order and without the MPU header bytes, the difference to that value in the
+     *     report before as a zigzag varint, 7 bits per byte, low bits first, bit 7 set on all but the last byte. A gap
+     *     in the sequence means a report was lost, the values can only be trusted again from the next keyframe on.
+     */
+    enum class TITinyConMpuFormats : uint8_t
+    {
+        Half = 0,
+        Raw,
+        Delta
+    };
+
     enum class TITinyConAccelerometerRanges : uint8_t
     {
         Invalid = 0,
@@ -0,0 +1,10 @@
+#pragma once
+
+#include <cstdint>
+
+namespace Tiny::Math
+{
+    template <typename TAxis>
+    struct TIQuaternion { TAxis W, X, Y, Z; };
+    using TIQuaternionF = TIQuaternion<float>;
+}
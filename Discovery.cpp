@@ -0,0 +1,143 @@
+#include "Discovery.h"
+
+using LogI2C = Tiny::TILogTarget<TinyCon::I2CLogLevel>;
+
+bool TinyCon::DiscoveryService::Watch(I2CAddress address, Callback callback, void* context)
+{
+    if (WatchCount >= MaxWatches)
+    {
+        LogI2C::Error("I2C: No room to watch 0x", address, Tiny::TIFormat::Hex, Tiny::TIEndl);
+        return false;
+    }
+    Watches[WatchCount++] = {address, callback, context, false, false, false, millis()};
+    return true;
+}
+
+bool TinyCon::DiscoveryService::Watch(I2CAddress address, DeviceInit& init, bool reportsLoss)
+{
+    if (!Watch(address, &OnDeviceInit, &init)) return false;
+    Watches[WatchCount - 1].ReportsLoss = reportsLoss;
+    init.Discovery = this;
+    init.Address = address;
+    return true;
+}
+
+void TinyCon::DiscoveryService::Update()
+{
+    auto watchProbed = false;
+    for (uint8_t i = 0; i < Budget; ++i)
+    {
+        auto& probe = Probes[i];
+        if (probe.Running) continue;
+
+        // At most one probe per tick for absent watched devices, so they never starve the sweep
+        I2CAddress address = watchProbed ? 0 : NextWatchAddress();
+        watchProbed |= address != 0;
+        const auto swept = !address;
+        if (!address) address = NextScanAddress();
+        if (!address) break;
+        // A device on the selected channel would answer for the bus itself, and then hide its address on every channel
+        if (swept && GetI2CChannel(address) == NoI2CChannel) Queue.DeselectChannels();
+        probe = {this, address, true, 0};
+        // A single byte read is the cheapest queued transaction that needs the address acknowledged
+        if (!Queue.Read(address, &probe.Value, 1, &OnProbed, &probe))
+        {
+            // The queue is full, try again next tick
+            probe.Running = false;
+            break;
+        }
+        if (auto* watch = Find(address)) watch->Probing = true;
+    }
+}
+
+void TinyCon::DiscoveryService::Lost(I2CAddress address)
+{
+    if (auto* watch = Find(address))
+    {
+        watch->Present = false;
+        watch->NextProbe = millis() + ProbeInterval;
+    }
+    SetPresent(address, false);
+}
+
+void TinyCon::DiscoveryService::SetPresent(I2CAddress address, bool present)
+{
+    const auto bus = GetI2CBusAddress(address);
+    auto& map = Topology[GetI2CChannel(address) + 1][bus >> 5];
+    if (present) map |= 1u << (bus & 31);
+    else map &= ~(1u << (bus & 31));
+}
+
+TinyCon::DiscoveryService::WatchEntry* TinyCon::DiscoveryService::Find(I2CAddress address)
+{
+    for (int8_t i = 0; i < WatchCount; ++i) if (Watches[i].Address == address) return &Watches[i];
+    return nullptr;
+}
+
+TinyCon::I2CAddress TinyCon::DiscoveryService::NextWatchAddress()
+{
+    const auto time = millis();
+    for (int8_t i = 0; i < WatchCount; ++i)
+    {
+        auto& watch = Watches[NextWatch];
+        NextWatch = (NextWatch + 1) % WatchCount;
+        if (!watch.Present && !watch.Probing && static_cast<int32_t>(time - watch.NextProbe) >= 0) return watch.Address;
+    }
+    return 0;
+}
+
+TinyCon::I2CAddress TinyCon::DiscoveryService::NextScanAddress()
+{
+    for (int16_t i = 0; i < (LastAddress - FirstAddress + 1) * (I2CMuxChannelCount + 1); ++i)
+    {
+        const auto address = NextScan;
+        if (GetI2CBusAddress(NextScan) < LastAddress) ++NextScan;
+        else
+        {
+            // On to the next channel, back to the bus itself after the last one
+            const auto channel = GetI2CChannel(NextScan) + 1;
+            NextScan = MakeI2CAddress(FirstAddress, channel < I2CMuxChannelCount ? channel : NoI2CChannel);
+            if (channel >= I2CMuxChannelCount) ++SweepCount;
+        }
+
+        // Whatever answers on the bus itself answers on every channel too, and so does the mux
+        const auto bus = GetI2CBusAddress(address);
+        if (GetI2CChannel(address) != NoI2CChannel && (bus == I2CMuxAddress || IsPresent(bus))) continue;
+        auto* watch = Find(address);
+        // Absent watched devices are covered above, on their own schedule, present ones are left to their drivers if
+        // those notice them departing
+        if (watch && (watch->Probing || !watch->Present || watch->ReportsLoss)) continue;
+        auto running = false;
+        for (const auto& probe : Probes) running |= probe.Running && probe.Address == address;
+        if (!running) return address;
+    }
+    return 0;
+}
+
+void TinyCon::DiscoveryService::OnProbed(void* context, const I2CTransaction& transaction)
+{
+    auto& probe = *static_cast<Probe*>(context);
+    auto& owner = *probe.Owner;
+    probe.Running = false;
+
+    const auto address = transaction.Address;
+    owner.SetPresent(address, transaction.Success);
+
+    auto* watch = owner.Find(address);
+    if (!watch) return;
+    watch->Probing = false;
+    if (!transaction.Success) watch->NextProbe = millis() + ProbeInterval;
+    if (transaction.Success == watch->Present) return;
+
+    watch->Present = transaction.Success;
+    LogI2C::Info("I2C: 0x", address, Tiny::TIFormat::Hex, watch->Present ? " arrived" : " departed", Tiny::TIEndl);
+    if (watch->Notify) watch->Notify(watch->Context, watch->Present);
+}
+
+void TinyCon::DiscoveryService::OnDeviceInit(void* context, bool present)
+{
+    auto& init = *static_cast<DeviceInit*>(context);
+    if (present && init.Is(DeviceStates::Absent)) init.Set(DeviceStates::Probing);
+    // A device being brought up may not answer for a while, e.g. during a reset, its driver deals with that itself
+    else if (!present && init.Is(DeviceStates::Present)) init.Set(DeviceStates::Absent);
+}
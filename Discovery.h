@@ -0,0 +1,133 @@
+#pragma once
+
+#include "Config.h"
+
+#include "I2CQueue.h"
+#include "Utilities.h"
+
+#include <Arduino.h>
+
+#include <array>
+#include <cstdint>
+
+namespace TinyCon
+{
+    enum class DeviceStates : uint8_t { Absent = 0, Probing, Resetting, Configuring, Settling, Present };
+    class DiscoveryService;
+
+    /**
+     * Resumable device bring-up, drivers advance it one small step per update and wait for the next step by time
+     * instead of blocking in delay(), so a device being attached never stalls the devices that are already running.
+     *
+     * Devices on I2C0 are watched by the discovery service instead of being probed by their driver, a watched device
+     * stays Absent at no cost until it answers, then starts at Probing, and drops back to Absent once it departs.
+     */
+    struct DeviceInit
+    {
+        // How often an absent device is probed for, on buses without a discovery service
+        static constexpr uint32_t ProbeInterval = 250;
+
+        DeviceStates State = DeviceStates::Absent;
+        uint32_t WaitUntil = 0;
+        uint8_t Retries = 0;
+        DiscoveryService* Discovery = nullptr;
+        I2CAddress Address = 0;
+
+        void Set(DeviceStates state) { State = state; WaitUntil = millis(); Retries = 0; }
+        void Wait(DeviceStates state, uint32_t time) { if (state != State) Retries = 0; State = state; WaitUntil = millis() + time; }
+        void Retry(uint32_t time) { ++Retries; WaitUntil = millis() + time; }
+        inline void Lost();
+        [[nodiscard]] bool Ready() const { return static_cast<int32_t>(millis() - WaitUntil) >= 0; }
+        [[nodiscard]] bool Is(DeviceStates state) const { return State == state; }
+        [[nodiscard]] bool IsWatched() const { return Discovery; }
+    };
+
+    /**
+     * Finds devices on I2C0 in the background, a few queued single byte reads per tick instead of each driver probing
+     * its own addresses. Drivers watch the addresses they handle and are told when a device arrives or departs. One probe
+     * per tick goes to the absent watched devices in turn, each of them every ProbeInterval, so plugging one in is
+     * noticed within a bounded time. The rest of the budget sweeps the address range for the topology map, which also
+     * notices watched devices departing. Drivers that notice their device departing themselves leave theirs out of the
+     * sweep once it is present, since a read where the driver left the register pointer takes data, e.g. out of a FIFO.
+     * Behind an I2C mux, the sweep covers the bus itself with all channels off and then one channel after
+     * the other, so apart from the switches back to the bus itself it costs a single switch per channel and sweep.
+     */
+    class DiscoveryService
+    {
+    public:
+        using Callback = void (*)(void* context, bool present);
+
+        // Every pad and IMU, plus the display, the haptics and whatever else sits on the bus
+        static constexpr int8_t MaxWatches = SeesawPadCount + MpuCount + 6;
+        static constexpr uint8_t MaxBudget = 4;
+        static constexpr uint8_t DefaultBudget = 2;
+        static constexpr uint8_t FirstAddress = 0x08;
+        static constexpr uint8_t LastAddress = 0x77;
+        // How often an absent watched device is probed in ms, also how long one its driver lost is left alone
+        static constexpr uint32_t ProbeInterval = 250;
+
+        explicit DiscoveryService(I2CQueue& queue) : Queue(queue) {}
+
+        /** Returns false if the watch list is full */
+        bool Watch(I2CAddress address, Callback callback, void* context);
+        /**
+         * Drives the bring-up state directly, for drivers built on DeviceInit. With reportsLoss, the driver calls Lost
+         * when its device stops answering, and the device is no longer probed while it is present.
+         */
+        bool Watch(I2CAddress address, DeviceInit& init, bool reportsLoss = false);
+        /** Queues up to the budget of probes, call once per tick */
+        void Update();
+        /** The driver lost its device, it is probed again after ProbeInterval */
+        void Lost(I2CAddress address);
+        void SetBudget(uint8_t probesPerTick) { Budget = Tiny::Math::Min(probesPerTick, MaxBudget); }
+
+        [[nodiscard]] bool IsPresent(I2CAddress address) const
+        { const auto bus = GetI2CBusAddress(address); return Topology[GetI2CChannel(address) + 1][bus >> 5] & (1u << (bus & 31)); }
+        /** Number of completed sweeps over the whole address range */
+        [[nodiscard]] uint32_t GetSweepCount() const { return SweepCount; }
+
+    private:
+        struct WatchEntry
+        {
+            I2CAddress Address = 0;
+            Callback Notify = nullptr;
+            void* Context = nullptr;
+            bool Present = false;
+            bool Probing = false;
+            bool ReportsLoss = false;
+            uint32_t NextProbe = 0;
+        };
+
+        struct Probe
+        {
+            DiscoveryService* Owner = nullptr;
+            I2CAddress Address = 0;
+            bool Running = false;
+            uint8_t Value = 0;
+        };
+
+        I2CQueue& Queue;
+        std::array<WatchEntry, MaxWatches> Watches{};
+        int8_t WatchCount = 0;
+        int8_t NextWatch = 0;
+        I2CAddress NextScan = FirstAddress;
+        uint8_t Budget = DefaultBudget;
+        uint32_t SweepCount = 0;
+        std::array<Probe, MaxBudget> Probes{};
+        // One map for the bus itself and one per mux channel
+        std::array<std::array<uint32_t, 4>, I2CMuxChannelCount + 1> Topology{};
+
+        [[nodiscard]] WatchEntry* Find(I2CAddress address);
+        [[nodiscard]] I2CAddress NextWatchAddress();
+        [[nodiscard]] I2CAddress NextScanAddress();
+        void SetPresent(I2CAddress address, bool present);
+        static void OnProbed(void* context, const I2CTransaction& transaction);
+        static void OnDeviceInit(void* context, bool present);
+    };
+
+    void DeviceInit::Lost()
+    {
+        Wait(DeviceStates::Absent, ProbeInterval);
+        if (Discovery) Discovery->Lost(Address);
+    }
+}
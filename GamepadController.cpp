@@ -1,43 +1,60 @@
 #include "GamepadController.h"
 
+#include <algorithm>
+
 using LogGamepad = Tiny::TILogTarget<TinyCon::GamepadLogLevel>;
 using LogI2C = Tiny::TILogTarget<TinyCon::I2CLogLevel>;
 
-void TinyCon::GamepadController::Init(int8_t hatOffset, const std::array<int8_t, MaxNativeAdcPinCount>& axisPins, const std::array<int8_t, MaxNativeGpioPinCount>& buttonPins, ActiveState activeState)
+namespace
 {
-    // Input -1 is always the device itself with raw ADC and GPIO pins
-    Inputs[Inputs.size() - 1].Init(axisPins, buttonPins, activeState);
-    for (std::size_t i = 0; i < Inputs.size() - 1; ++i) Inputs[i].Init(I2C0, i);
-    auto anyMpuInitialized = false;
-    for (std::size_t i = 0; i < Mpus.size(); ++i)
+    /** The pins, NC-terminated, a zero would be pin 0 */
+    template <std::size_t Size>
+    std::array<int8_t, Size> MakePins(std::initializer_list<int8_t> pins)
     {
-        Mpus[i].Init(I2C0, i);
-        if (!anyMpuInitialized) Mpus[i].Update();
-        anyMpuInitialized |= Mpus[i].Present;
+        std::array<int8_t, Size> result;
+        result.fill(TinyCon::NC);
+        std::copy_n(pins.begin(), Tiny::Math::Min(pins.size(), Size), result.begin());
+        return result;
     }
-    Haptics[1].Init(I2C0);
+}
+
+void TinyCon::GamepadController::Init(int8_t hatOffset, std::initializer_list<int8_t> axisPins, std::initializer_list<int8_t> buttonPins, ActiveState activeState)
+{
+    // Input -1 is always the device itself with raw ADC and GPIO pins
+    Inputs[Inputs.size() - 1].Init(MakePins<MaxNativeAdcPinCount>(axisPins), MakePins<MaxNativeGpioPinCount>(buttonPins), activeState);
+    for (std::size_t i = 0; i < Inputs.size() - 1; ++i) Inputs[i].Init(I2C0, I2C0Queue, Discovery, i);
+    // Devices on I2C0 come up once the discovery service found them, the software bus still probes on its own
+    constexpr auto mpuInterruptPins = sizeof(MpuInterruptPins) / sizeof(MpuInterruptPins[0]);
+    for (std::size_t i = 0; i < Mpus.size(); ++i) Mpus[i].Init(I2C0Queue, Discovery, i, i < mpuInterruptPins ? MpuInterruptPins[i] : NC);
+    Haptics[1].Init(I2C0Queue, Discovery);
     Haptics[0].Init(I2C1);
     HatOffset = hatOffset;
+    SnapshotInputs();
+    SnapshotMpus();
 }
 
-void TinyCon::GamepadController::Update(uint32_t deltaTime)
+void TinyCon::GamepadController::LogBuses()
 {
     if constexpr (Tiny::GlobalLogThreshold >= Tiny::TILogLevel::Verbose)
     {
-        LogI2C::Verbose("I2C0 Devices: ");
+        // The discovery service sweeps I2C0 in the background anyway, so this costs no bus time
         bool found = false;
-        for (auto addr = 0x02; addr < 0x78; ++addr)
+        for (int8_t channel = NoI2CChannel; channel < I2CMuxChannelCount; ++channel)
         {
-            I2C0.beginTransmission(addr);
-            if (I2C0.endTransmission() == 0)
+            if (channel == NoI2CChannel) LogI2C::Verbose("I2C0 Devices: ");
+            else LogI2C::Verbose("I2C0 Channel ", channel, " Devices: ");
+            found = false;
+            for (int16_t addr = DiscoveryService::FirstAddress; addr <= DiscoveryService::LastAddress; ++addr)
             {
-                if (found) LogI2C::Verbose(", ");
-                found = true;
-                LogI2C::Verbose("0x", addr, Tiny::TIFormat::Hex);
+                if (Discovery.IsPresent(MakeI2CAddress(addr, channel)))
+                {
+                    if (found) LogI2C::Verbose(", ");
+                    found = true;
+                    LogI2C::Verbose("0x", addr, Tiny::TIFormat::Hex);
+                }
             }
+            LogI2C::Verbose(Tiny::TIEndl);
         }
-
-        LogI2C::Verbose(Tiny::TIEndl);
         LogI2C::Verbose("I2C1 Devices: ");
         found = false;
         for (auto addr = 0x02; addr < 0x78; ++addr)
@@ -52,29 +69,48 @@ void TinyCon::GamepadController::Update(uint32_t deltaTime)
         }
         LogI2C::Verbose(Tiny::TIEndl);
     }
+}
 
-    I2C0.setClock(400000);
-    LogGamepad::Info("Controller Update:", Tiny::TIEndl);
-    auto mpuInitialized = false;
+void TinyCon::GamepadController::UpdateMpus()
+{
+    // All FIFOs are drained through the queue, the sensors behind the same mux channel one after the other
+    for (auto& mpu : Mpus) if (mpu.Present) mpu.Update();
+    I2C0Queue.Flush();
     for (auto& mpu : Mpus)
     {
-        auto time = millis();
-        auto mpuWasPresent = mpu.Present;
-        if (!mpuInitialized || mpu.Present) mpu.Update();
-        if (!mpuWasPresent && mpu.Present) mpuInitialized = true;
-        LogGamepad::Debug("    MPU: (", mpu.Acceleration.X, ", ", mpu.Acceleration.Y, ", ", mpu.Acceleration.Z,
-                          "), (", mpu.AngularVelocity.X, ", ", mpu.AngularVelocity.Y, ", ", mpu.AngularVelocity.Z,
-                          "), (", mpu.Orientation.X, ", ", mpu.Orientation.Y, ", ", mpu.Orientation.Z,
-                          "), ", mpu.Temperature, ", ", millis() - time, "ms", Tiny::TIEndl);
+        if (!mpu.Present) continue;
+        const auto acceleration = mpu.GetAcceleration();
+        const auto angularVelocity = mpu.GetAngularVelocity();
+        const auto orientation = mpu.GetOrientation();
+        LogGamepad::Debug("    MPU: ", mpu.GetBatchSize(), " samples, (", acceleration.X, ", ", acceleration.Y, ", ", acceleration.Z,
+                          "), (", angularVelocity.X, ", ", angularVelocity.Y, ", ", angularVelocity.Z,
+                          "), (", orientation.X, ", ", orientation.Y, ", ", orientation.Z,
+                          "), ", mpu.GetTemperature(), Tiny::TIEndl);
     }
+    SnapshotMpus();
+}
 
-    I2C0.setClock(800000);
+void TinyCon::GamepadController::UpdateInputs()
+{
+    UpdateSeesaws();
+    for (std::size_t i = 0; i < Inputs.size(); ++i)
+        if (auto& input = Inputs[i]; input.Present)
+        {
+            // Inputs past the last input stage share it, see TITinyConProfileStages
+            constexpr auto inputStages = static_cast<uint8_t>(Profiler::Stages::Input5) - static_cast<uint8_t>(Profiler::Stages::Input1) + 1;
+            const auto stage = static_cast<uint8_t>(Profiler::Stages::Input1) + Tiny::Math::Min<std::size_t, std::size_t>(i, inputStages - 1);
+            const auto scope = Profile.Measure(Profiler::Stages(stage));
+            input.Update();
+        }
+}
+
+void TinyCon::GamepadController::DecimateInputs()
+{
     for (auto& input : Inputs)
         if (input.Present)
         {
-            auto time = millis();
+            input.Decimate();
             LogGamepad::Debug("    Input: (");
-            input.Update();
             for (int8_t j = 0; j < input.GetAxisCount(); ++j)
             {
                 if (j > 0) LogGamepad::Debug(", ");
@@ -84,64 +120,196 @@ void TinyCon::GamepadController::Update(uint32_t deltaTime)
             for (int8_t j = 0; j < input.GetButtonCount(); ++j)
             {
                 if (j > 0) LogGamepad::Debug(", ");
-                LogGamepad::Debug(input.Buttons[j] ? "Down" : "Up");
+                LogGamepad::Debug(input.GetButton(j) ? "Down" : "Up");
             }
-            LogGamepad::Debug("), ", millis() - time, "ms", Tiny::TIEndl);
+            LogGamepad::Debug(")", Tiny::TIEndl);
         }
+    SnapshotInputs();
+}
 
-    I2C0.setClock(400000);
+void TinyCon::GamepadController::SnapshotInputs()
+{
+    Frame.Buttons = 0;
+    Frame.ButtonCount = Frame.AxisCount = 0;
+    Frame.InputTimestamp = 0;
+    auto first = true;
+    for (std::size_t i = 0; i < Inputs.size(); ++i)
+    {
+        // An input that is not present has no buttons or axis, whatever it last read
+        const auto& input = Inputs[i];
+        const auto buttonCount = input.GetButtonCount();
+        if (buttonCount > 0 && Frame.ButtonCount < 32)
+            Frame.Buttons |= (buttonCount >= 32 ? input.Buttons : input.Buttons & ((1u << buttonCount) - 1)) << Frame.ButtonCount;
+        for (int8_t j = 0; j < buttonCount; ++j, ++Frame.ButtonCount)
+        {
+            Frame.ButtonInput[Frame.ButtonCount] = i;
+            Frame.ButtonIndex[Frame.ButtonCount] = j;
+        }
+        const auto axisCount = input.GetAxisCount();
+        for (int8_t j = 0; j < axisCount; ++j, ++Frame.AxisCount)
+        {
+            Frame.Axis[Frame.AxisCount] = input.Axis[j];
+            Frame.AxisInput[Frame.AxisCount] = i;
+            Frame.AxisIndex[Frame.AxisCount] = j;
+        }
+
+        // Wrap-safe, micros() overflows after about 71 minutes
+        if (input.Present && input.Timestamp && (first || static_cast<int32_t>(input.Timestamp - Frame.InputTimestamp) > 0))
+        {
+            Frame.InputTimestamp = input.Timestamp;
+            first = false;
+        }
+    }
+}
+
+void TinyCon::GamepadController::SnapshotMpus()
+{
+    Frame.MpuCount = 0;
+    Frame.MpuSize = 0;
+    Frame.MpuRawSize = 0;
+    Frame.MpuTimestamp = 0;
+    for (auto& mpu : Mpus) if (mpu.Present)
+    {
+        Frame.MpuSize += mpu.FillBuffer({Frame.Mpu.data() + Frame.MpuSize, Frame.Mpu.size() - Frame.MpuSize});
+        Frame.MpuRawSize += mpu.FillRawBuffer({Frame.MpuRaw.data() + Frame.MpuRawSize, Frame.MpuRaw.size() - Frame.MpuRawSize});
+        if (!Frame.MpuCount++ || static_cast<int32_t>(mpu.GetTimestamp() - Frame.MpuTimestamp) < 0) Frame.MpuTimestamp = mpu.GetTimestamp();
+    }
+}
+
+void TinyCon::GamepadController::UpdateSeesaws()
+{
+    // Every pad gets the select of a phase before any of them is read, so all pads share one conversion delay per
+    // phase instead of each waiting for its own, and four pads cost about as much as one.
+    // Pads are numbered by mux channel, so going through them in order switches each channel once per pass. Every
+    // pass goes the other way than the one before, so it starts on the channel the previous pass ended on.
+    for (auto& input : Inputs) if (auto* seesaw = input.GetSeesaw()) seesaw->Prepare();
+    auto forward = true;
+    const auto pass = [this, &forward](auto&& function)
+    {
+        const int8_t count = Inputs.size();
+        for (int8_t i = 0; i < count; ++i)
+            if (auto* seesaw = Inputs[forward ? i : count - 1 - i].GetSeesaw()) function(*seesaw);
+        if (I2CMuxChannelCount > 0) forward = !forward;
+    };
+    for (uint8_t i = 0; i < SeesawController::PhaseCount; ++i)
+    {
+        const auto phase = static_cast<SeesawController::Phases>(i);
+        int32_t wait = -1;
+        pass([&](SeesawController& seesaw) { if (seesaw.Request(phase)) wait = Tiny::Math::Max<int32_t>(wait, seesaw.GetDelay(phase)); });
+        if (wait < 0) continue;
+
+        I2C0Queue.Flush();
+        if (wait > 0) delayMicroseconds(wait);
+        pass([&](SeesawController& seesaw) { seesaw.Collect(phase); });
+    }
+    I2C0Queue.Flush();
+}
+
+void TinyCon::GamepadController::UpdateDevices()
+{
+    // Every device the discovery service found advances its bring-up by at most one short step, so a device being
+    // attached never holds up the devices that are already running, and a missing one costs nothing here.
+    I2C0Queue.SelectDefault();
+    for (auto& mpu : Mpus) if (!mpu.Present) mpu.Update();
+    for (auto& input : Inputs) if (!input.Present) input.Update();
+    for (auto& haptic : Haptics) haptic.UpdateInit();
+
+    // Devices seen for the first time get the fastest clock that still reads back correctly
+    auto calibrated = false;
+    for (auto& mpu : Mpus) if (mpu.Present) calibrated |= Calibrate(mpu.GetCalibration());
+    for (auto& input : Inputs) calibrated |= Calibrate(input.GetCalibration());
+    for (auto& haptic : Haptics) calibrated |= Calibrate(haptic.GetCalibration());
+    if (calibrated) I2C0Queue.GetProfiles().Save();
+    for (auto& mpu : Mpus) if (mpu.Present) mpu.SaveGyroBias();
+
+    // Devices that came or went change the layout of the snapshot
+    SnapshotInputs();
+    SnapshotMpus();
+}
+
+bool TinyCon::GamepadController::Calibrate(const BusCalibration& calibration)
+{
+    if (!calibration.Address || I2C0Queue.GetProfiles().Get(calibration.Address).Calibrated) return false;
+    return I2C0Queue.Calibrate(calibration);
+}
+
+void TinyCon::GamepadController::UpdateHaptics(uint32_t deltaTime)
+{
     for (auto& haptic : Haptics)
         if (haptic.Present && haptic.Enabled)
         {
-            auto time = millis();
             LogGamepad::Debug("    Haptic: ", haptic.Available(), " ");
             haptic.Update(deltaTime);
-            LogGamepad::Debug(", ", millis() - time, "ms");
             LogGamepad::Info(Tiny::TIEndl);
         }
 }
 
+bool TinyCon::GamepadController::HasHapticCommands() const
+{
+    for (auto& haptic : Haptics)
+        if (haptic.Present && haptic.Enabled && haptic.HasValues()) return true;
+    return false;
+}
+
 #if !NO_BLE || !NO_USB
-hid_gamepad_report_t TinyCon::GamepadController::MakeHidReport() const
+hid_gamepad_report_t TinyCon::GamepadController::MakeHidReport(uint32_t* timestamp) const
 {
     hid_gamepad_report_t report = {};
+    if (timestamp) *timestamp = GetInputTimestamp();
 
     // XXX: Figure out how we can support more than 2+1 axis per controller
     // Assume any extra axis is 0-ed if not available or the controller is disabled
-    report.x = GetAxis(0) * 127;
-    report.y = GetAxis(1) * 127;
-    report.z = GetAxis(2) * 127;
-    report.rz = GetAxis(3) * 127;
-    report.rx = GetAxis(4) * 127;
-    report.ry = GetAxis(5) * 127;
-
-    if (HatOffset < 0) report.hat = GAMEPAD_HAT_CENTERED;
-    else
+    report.x = GetAxis(0) >> 8;
+    report.y = GetAxis(1) >> 8;
+    report.z = GetAxis(2) >> 8;
+    report.rz = GetAxis(3) >> 8;
+    report.rx = GetAxis(4) >> 8;
+    report.ry = GetAxis(5) >> 8;
+
+    const auto buttons = GetButtons();
+    if (HatOffset < 0 || HatOffset > 28)
     {
-        // Figure out the hat, clock-wise starting at the top position button. Offsetting this by 5
-        if (GetButton(HatOffset) && GetButton(HatOffset + 3)) report.hat = GAMEPAD_HAT_UP_LEFT;
-        else if (GetButton(HatOffset) && GetButton(HatOffset + 1)) report.hat = GAMEPAD_HAT_UP_RIGHT;
-        else if (GetButton(HatOffset)) report.hat = GAMEPAD_HAT_UP;
-        else if (GetButton(HatOffset + 1) && GetButton(HatOffset + 2)) report.hat = GAMEPAD_HAT_DOWN_RIGHT;
-        else if (GetButton(HatOffset + 1)) report.hat = GAMEPAD_HAT_RIGHT;
-        else if (GetButton(HatOffset + 2) && GetButton(HatOffset + 3)) report.hat = GAMEPAD_HAT_DOWN_LEFT;
-        else if (GetButton(HatOffset + 2)) report.hat = GAMEPAD_HAT_DOWN;
-        else if (GetButton(HatOffset + 3)) report.hat = GAMEPAD_HAT_LEFT;
-        else report.hat = GAMEPAD_HAT_CENTERED;
+        report.hat = GAMEPAD_HAT_CENTERED;
+        report.buttons = buttons;
+        return report;
     }
 
-    for (int8_t index = 0; index < 32; ++index)
-        if (HatOffset < 0 || index < HatOffset) report.buttons |= GetButton(index) << (index);
-        else report.buttons |= GetButton(index + 4) << (index);
+    // Figure out the hat, clock-wise starting at the top position button. Offsetting this by 5
+    const auto hat = (buttons >> HatOffset) & 0xF;
+    const auto up = hat & 1, right = hat & 2, down = hat & 4, left = hat & 8;
+    if (up && left) report.hat = GAMEPAD_HAT_UP_LEFT;
+    else if (up && right) report.hat = GAMEPAD_HAT_UP_RIGHT;
+    else if (up) report.hat = GAMEPAD_HAT_UP;
+    else if (right && down) report.hat = GAMEPAD_HAT_DOWN_RIGHT;
+    else if (right) report.hat = GAMEPAD_HAT_RIGHT;
+    else if (down && left) report.hat = GAMEPAD_HAT_DOWN_LEFT;
+    else if (down) report.hat = GAMEPAD_HAT_DOWN;
+    else if (left) report.hat = GAMEPAD_HAT_LEFT;
+    else report.hat = GAMEPAD_HAT_CENTERED;
+
+    // The hat buttons are taken out, the ones after them move down
+    const auto below = (1u << HatOffset) - 1;
+    report.buttons = (buttons & below) | ((HatOffset + 4 < 32 ? buttons >> (HatOffset + 4) : 0) << HatOffset);
     return report;
 }
 #endif
 
-std::size_t TinyCon::GamepadController::MakeMpuBuffer(Tiny::Collections::TIFixedSpan<uint8_t> data) const
+std::size_t TinyCon::GamepadController::MakeMpuBuffer(Tiny::Collections::TIFixedSpan<uint8_t> data, uint32_t* timestamp) const
 {
-    auto size = 0;
-    for (auto& mpu : Mpus) if (mpu.Present)
-        size += mpu.FillBuffer({data.data() + size, data.size()});
+    if (timestamp) *timestamp = Frame.MpuTimestamp;
+    // Every MPU has the same fields, a partial one would read as one with fewer
+    const auto mpuSize = Frame.MpuCount ? Frame.MpuSize / Frame.MpuCount : 0;
+    const auto size = mpuSize ? Tiny::Math::Min(static_cast<std::size_t>(Frame.MpuSize), data.size() / mpuSize * mpuSize) : 0;
+    memcpy(const_cast<uint8_t*>(data.data()), Frame.Mpu.data(), size);
+    return size;
+}
+
+std::size_t TinyCon::GamepadController::MakeMpuRawBuffer(Tiny::Collections::TIFixedSpan<uint8_t> data) const
+{
+    // Every MPU has the same fields, a partial one would read as one with fewer
+    const auto mpuSize = Frame.MpuCount ? Frame.MpuRawSize / Frame.MpuCount : 0;
+    const auto size = mpuSize ? Tiny::Math::Min(static_cast<std::size_t>(Frame.MpuRawSize), data.size() / mpuSize * mpuSize) : 0;
+    memcpy(const_cast<uint8_t*>(data.data()), Frame.MpuRaw.data(), size);
     return size;
 }
 
@@ -163,34 +331,31 @@ void TinyCon::GamepadController::AddHapticCommand(Tiny::Collections::TIFixedSpan
     }
 }
 
-float TinyCon::GamepadController::GetAxis(int8_t axisIndex) const
+TinyCon::AxisProcessor* TinyCon::GamepadController::GetAxisProcessor(int8_t axisIndex)
 {
-    for (auto& input : Inputs)
-        if (axisIndex < input.GetAxisCount()) return input.Axis[axisIndex];
-        else axisIndex -= input.GetAxisCount();
-    return 0.0f;
+    if (axisIndex < 0 || axisIndex >= Frame.AxisCount) return nullptr;
+    return &Inputs[Frame.AxisInput[axisIndex]].GetAxisProcessor(Frame.AxisIndex[axisIndex]);
 }
 
-bool TinyCon::GamepadController::GetButton(int8_t buttonIndex) const
+bool TinyCon::GamepadController::GetUpdatedButton(int8_t buttonIndex) const
 {
-    for (auto& input : Inputs)
-        if (buttonIndex < input.GetButtonCount()) return input.Buttons[buttonIndex];
-        else buttonIndex -= input.GetButtonCount();
-    return false;
+    if (buttonIndex < 0 || buttonIndex >= Frame.ButtonCount) return false;
+    I2C0Queue.Flush();
+    return Inputs[Frame.ButtonInput[buttonIndex]].GetUpdatedButton(Frame.ButtonIndex[buttonIndex]);
 }
 
-bool TinyCon::GamepadController::GetUpdatedButton(int8_t buttonIndex) const
+bool TinyCon::GamepadController::CanWakeOnButton(int8_t buttonIndex) const
 {
-    for (auto& input : Inputs)
-        if (buttonIndex < input.GetButtonCount()) return input.GetUpdatedButton(buttonIndex);
-        else buttonIndex -= input.GetButtonCount();
-    return false;
+    return buttonIndex >= 0 && buttonIndex < Frame.ButtonCount && Inputs[Frame.ButtonInput[buttonIndex]].CanWake();
 }
 
 void TinyCon::GamepadController::Reset()
 {
     Id = 0;
+    MpuFormat = Tiny::Drivers::Input::TITinyConMpuFormats::Half;
     for (auto& haptic : Haptics) haptic.Reset();
     for (auto& mpu : Mpus) mpu.Reset();
     for (auto& input : Inputs) input.Reset();
+    SnapshotInputs();
+    SnapshotMpus();
 }
@@ -2,12 +2,17 @@
 
 #include "Config.h"
 
+#include "Discovery.h"
 #include "HapticController.h"
+#include "I2CQueue.h"
 #include "MpuController.h"
 #include "InputController.h"
+#include "Profiler.h"
 
 #include <Arduino.h>
 #include <Wire.h>
+
+#include <initializer_list>
 #if !NO_BLE
 #include <bluefruit.h>
 #endif
@@ -20,40 +25,117 @@ namespace TinyCon
     class GamepadController
     {
     public:
-        static constexpr uint8_t MaxInputControllers = 5;
-        static constexpr uint8_t MaxMpuControllers = 2;
+        // Every Seesaw pad plus the native pins, which are always the last input
+        static constexpr uint8_t MaxInputControllers = SeesawController::MaxControllers + 1;
+        static constexpr uint8_t MaxMpuControllers = MpuController::MaxControllers;
         static constexpr uint8_t MaxHapticControllers = 2;
 
-        GamepadController(TwoWire& i2c0, SoftWire& i2c1) : I2C0(i2c0), I2C1(i2c1) {}
+        /**
+         * Everything the reports read of the inputs and MPUs, packed once per update. Buttons and axis are in input
+         * order and each one keeps the input it came from and its index there, so reading one never walks the inputs.
+         * The MPU samples are already in the half-float format of the data registers, and in counts for the Raw and
+         * Delta formats.
+         */
+        struct Snapshot
+        {
+            static constexpr int16_t MaxAxis = MaxInputControllers * InputController::MaxAxisCount;
+            static constexpr int16_t MaxButtons = INT8_MAX;
+            static constexpr int16_t MaxMpuData = MaxMpuControllers * MpuController::MaxBufferSize;
+            static constexpr int16_t MaxMpuRawData = MaxMpuControllers * MpuController::MaxRawBufferSize;
+
+            // One bit per button for the first 32 buttons
+            uint32_t Buttons = 0;
+            int16_t ButtonCount = 0;
+            std::array<int8_t, MaxButtons> ButtonInput{};
+            std::array<int8_t, MaxButtons> ButtonIndex{};
+            int16_t AxisCount = 0;
+            std::array<int16_t, MaxAxis> Axis{};
+            std::array<int8_t, MaxAxis> AxisInput{};
+            std::array<int8_t, MaxAxis> AxisIndex{};
+            // Edge time of the most recent button change
+            uint32_t InputTimestamp = 0;
+
+            int8_t MpuCount = 0;
+            uint16_t MpuSize = 0;
+            std::array<uint8_t, MaxMpuData> Mpu{};
+            uint16_t MpuRawSize = 0;
+            std::array<uint8_t, MaxMpuRawData> MpuRaw{};
+            // Acquisition time of the oldest sample
+            uint32_t MpuTimestamp = 0;
+        };
+        static_assert(MaxNativeGpioPinCount + (MaxInputControllers - 1) * SeesawController::GetButtonCount() <= Snapshot::MaxButtons);
+        static_assert(Snapshot::MaxAxis <= INT8_MAX, "Axis are addressed by int8_t");
 
-        void Init(int8_t hatOffset = -1, const std::array<int8_t, MaxNativeAdcPinCount>& axisPins = {NC}, const std::array<int8_t, MaxNativeGpioPinCount>& buttonPins = {NC}, ActiveState activeState = ActiveState::Low);
-        void Update(uint32_t deltaTime);
+        GamepadController(TwoWire& i2c0, I2CQueue& i2c0Queue, DiscoveryService& discovery, SoftWire& i2c1, Profiler& profile)
+            : I2C0(i2c0), I2C0Queue(i2c0Queue), Discovery(discovery), I2C1(i2c1), Profile(profile) {}
+
+        /** The native pins in order, the ones left out are NC */
+        void Init(int8_t hatOffset = -1, std::initializer_list<int8_t> axisPins = {}, std::initializer_list<int8_t> buttonPins = {}, ActiveState activeState = ActiveState::Low);
+        /** Split per subsystem, so each one can be scheduled at its own rate */
+        void UpdateMpus();
+        /** Samples the inputs, the snapshot only changes in DecimateInputs */
+        void UpdateInputs();
+        /** Decimates the input samples since the last call into the snapshot, call once per report */
+        void DecimateInputs();
+        void UpdateHaptics(uint32_t deltaTime);
+        /** Advances the initialization of devices that are not present yet, call after DiscoveryService::Update */
+        void UpdateDevices();
+        void LogBuses();
     #if !NO_BLE || !NO_USB
-        [[nodiscard]] hid_gamepad_report_t MakeHidReport() const;
+        /** The timestamp, if given, receives the edge time of the most recent button change in the report */
+        [[nodiscard]] hid_gamepad_report_t MakeHidReport(uint32_t* timestamp = nullptr) const;
     #endif
-        [[nodiscard]] std::size_t MakeMpuBuffer(Tiny::Collections::TIFixedSpan<uint8_t> data) const;
+        /** Only whole MPUs, as many as fit. The timestamp, if given, receives the acquisition time of the oldest sample. */
+        [[nodiscard]] std::size_t MakeMpuBuffer(Tiny::Collections::TIFixedSpan<uint8_t> data, uint32_t* timestamp = nullptr) const;
+        /** In the Raw MPU format, only whole MPUs, as many as fit */
+        [[nodiscard]] std::size_t MakeMpuRawBuffer(Tiny::Collections::TIFixedSpan<uint8_t> data) const;
+        [[nodiscard]] uint32_t GetInputTimestamp() const { return Frame.InputTimestamp; }
+        [[nodiscard]] const Snapshot& GetSnapshot() const { return Frame; }
 
         [[nodiscard]] bool GetInputPresent(int8_t controller) const { return Inputs[controller].Present; }
         [[nodiscard]] Tiny::Drivers::Input::TITinyConControllerTypes GetControllerType(int8_t input) const { return Inputs[input].GetType(); }
         [[nodiscard]] int16_t GetAxisCount(int8_t input) const { return Inputs[input].GetAxisCount(); }
-        [[nodiscard]] float GetAxis(int8_t controller, int8_t axisIndex)const  { return Inputs[controller].Axis[axisIndex]; }
-        [[nodiscard]] int16_t GetAxisCount() const { int8_t count = 0; for (auto& input : Inputs) count += input.GetAxisCount(); return count; }
-        [[nodiscard]] float GetAxis(int8_t axisIndex) const;
+        [[nodiscard]] int16_t GetAxis(int8_t controller, int8_t axisIndex)const  { return Inputs[controller].Axis[axisIndex]; }
+        [[nodiscard]] int16_t GetAxisCount() const { return Frame.AxisCount; }
+        /** Calibrated and shaped, in Q15 */
+        [[nodiscard]] int16_t GetAxis(int8_t axisIndex) const { return axisIndex >= 0 && axisIndex < Frame.AxisCount ? Frame.Axis[axisIndex] : 0; }
+        /** The processor of the axis in input order, null if there is no such axis */
+        [[nodiscard]] AxisProcessor* GetAxisProcessor(int8_t axisIndex);
         [[nodiscard]] int16_t GetButtonCount(int8_t input) const { return Inputs[input].GetButtonCount(); }
-        [[nodiscard]] bool GetButton(int8_t input, int8_t buttonIndex) const { return Inputs[input].Buttons[buttonIndex]; }
-        [[nodiscard]] int16_t GetButtonCount() const { int8_t count = 0; for (auto& input : Inputs) count += input.GetButtonCount(); return count; }
-        [[nodiscard]] bool GetButton(int8_t buttonIndex) const;
+        [[nodiscard]] bool GetButton(int8_t input, int8_t buttonIndex) const { return Inputs[input].GetButton(buttonIndex); }
+        [[nodiscard]] int16_t GetButtonCount() const { return Frame.ButtonCount; }
+        [[nodiscard]] bool GetButton(int8_t buttonIndex) const { return buttonIndex >= 0 && buttonIndex < 32 && (Frame.Buttons >> buttonIndex) & 1; }
+        /** All buttons of all inputs, one bit each in input order */
+        [[nodiscard]] uint32_t GetButtons() const { return Frame.Buttons; }
         [[nodiscard]] bool GetUpdatedButton(int8_t buttonIndex) const;
+        /** True if a change of the given button wakes the firmware through an interrupt line */
+        [[nodiscard]] bool CanWakeOnButton(int8_t buttonIndex) const;
+        [[nodiscard]] bool HasPendingInput() const { return SeesawController::IsInterruptPending(); }
 
         [[nodiscard]] bool GetAccelerationEnabled() const { return Mpus[0].AccelerationEnabled; }
-        void SetAccelerationEnabled(bool enabled) { for (auto& mpu : Mpus) mpu.AccelerationEnabled = enabled; }
+        void SetAccelerationEnabled(bool enabled) { for (auto& mpu : Mpus) mpu.AccelerationEnabled = enabled; SnapshotMpus(); }
         [[nodiscard]] bool GetAngularVelocityEnabled() const { return Mpus[0].AngularVelocityEnabled; }
-        void SetAngularVelocityEnabled(bool enabled) { for (auto& mpu : Mpus) mpu.AngularVelocityEnabled = enabled; }
+        void SetAngularVelocityEnabled(bool enabled) { for (auto& mpu : Mpus) mpu.AngularVelocityEnabled = enabled; SnapshotMpus(); }
         [[nodiscard]] bool GetOrientationEnabled() const { return Mpus[0].OrientationEnabled; }
-        void SetOrientationEnabled(bool enabled) { for (auto& mpu : Mpus) mpu.OrientationEnabled = enabled; }
+        void SetOrientationEnabled(bool enabled) { for (auto& mpu : Mpus) mpu.OrientationEnabled = enabled; SnapshotMpus(); }
         [[nodiscard]] bool GetTemperatureEnabled() const { return Mpus[0].TemperatureEnabled; }
-        void SetTemperatureEnabled(bool enabled) { for (auto& mpu : Mpus) mpu.TemperatureEnabled = enabled; }
-        [[nodiscard]] int8_t GetMpuCount() const { int8_t count = 0; for (auto & Mpu : Mpus) if (Mpu.Present) ++count; return count; }
+        void SetTemperatureEnabled(bool enabled) { for (auto& mpu : Mpus) mpu.TemperatureEnabled = enabled; SnapshotMpus(); }
+        [[nodiscard]] bool GetQuaternionEnabled() const { return Mpus[0].QuaternionEnabled; }
+        void SetQuaternionEnabled(bool enabled) { for (auto& mpu : Mpus) mpu.QuaternionEnabled = enabled; SnapshotMpus(); }
+        [[nodiscard]] bool GetTimestampEnabled() const { return Mpus[0].TimestampEnabled; }
+        void SetTimestampEnabled(bool enabled) { for (auto& mpu : Mpus) mpu.TimestampEnabled = enabled; SnapshotMpus(); }
+        [[nodiscard]] bool GetMagnetometerCountEnabled() const { return Mpus[0].MagnetometerCountEnabled; }
+        void SetMagnetometerCountEnabled(bool enabled) { for (auto& mpu : Mpus) mpu.MagnetometerCountEnabled = enabled; SnapshotMpus(); }
+        /** The wire format of the MPU data in the reports */
+        [[nodiscard]] Tiny::Drivers::Input::TITinyConMpuFormats GetMpuFormat() const { return MpuFormat; }
+        void SetMpuFormat(Tiny::Drivers::Input::TITinyConMpuFormats format) { MpuFormat = format; }
+        /** The enabled MPU data as in the MPUDataEnable register, which is what decides the layout of the MPU buffer */
+        [[nodiscard]] uint8_t GetMpuFields() const
+        {
+            return GetMagnetometerCountEnabled() << 6 | GetTimestampEnabled() << 5 | GetQuaternionEnabled() << 4 | GetAccelerationEnabled() << 3 | GetAngularVelocityEnabled() << 2 |
+                   GetOrientationEnabled() << 1 | GetTemperatureEnabled();
+        }
+        [[nodiscard]] int8_t GetMpuCount() const { return Frame.MpuCount; }
         [[nodiscard]] bool GetMpuPresent(int8_t mpu) const { return Mpus[mpu].Present; }
         [[nodiscard]] Tiny::Drivers::Input::TITinyConMpuTypes GetMpuType(int8_t mpu) const { return Mpus[mpu].GetType(); }
 
@@ -62,9 +144,15 @@ namespace TinyCon
         [[nodiscard]] Tiny::Drivers::Input::TITinyConGyroscopeRanges GetGyroscopeRange(int8_t mpu) const { return Mpus[mpu].GetGyroscopeRange(); }
         void SetGyroscopeRange(int8_t mpu, Tiny::Drivers::Input::TITinyConGyroscopeRanges range) { Mpus[mpu].SetGyroscopeRange(range); }
 
-        [[nodiscard]] Tiny::Math::TIVector3F GetAcceleration(int8_t mpu) const { return Mpus[mpu].Acceleration; }
-        [[nodiscard]] Tiny::Math::TIVector3F GetAngularVelocity(int8_t mpu) const { return Mpus[mpu].AngularVelocity; }
-        [[nodiscard]] Tiny::Math::TIVector3F GetOrientation(int8_t mpu) const { return Mpus[mpu].Orientation; }
+        [[nodiscard]] Tiny::Math::TIVector3F GetAcceleration(int8_t mpu) const { return Mpus[mpu].GetAcceleration(); }
+        [[nodiscard]] Tiny::Math::TIVector3F GetAngularVelocity(int8_t mpu) const { return Mpus[mpu].GetAngularVelocity(); }
+        [[nodiscard]] Tiny::Math::TIVector3F GetOrientation(int8_t mpu) const { return Mpus[mpu].GetOrientation(); }
+        /** Fused on the device, sensor to earth frame with Z up */
+        [[nodiscard]] Tiny::Math::TIQuaternionF GetQuaternion(int8_t mpu) const { return Mpus[mpu].GetQuaternion(); }
+        /** The FIFO samples of the last MPU update, oldest first, in counts that the MPU scales */
+        [[nodiscard]] uint8_t GetMpuBatchSize(int8_t mpu) const { return Mpus[mpu].GetBatchSize(); }
+        [[nodiscard]] const MpuController::Sample& GetMpuSample(int8_t mpu, uint8_t index) const { return Mpus[mpu].GetSample(index); }
+        [[nodiscard]] const MpuController& GetMpu(int8_t mpu) const { return Mpus[mpu]; }
 
         [[nodiscard]] bool GetHapticEnabled(int8_t haptic) const { return Haptics[haptic].Enabled; }
         void SetHapticEnabled(int8_t haptic, bool enabled) { Haptics[haptic].Enabled = enabled; }
@@ -77,18 +165,36 @@ namespace TinyCon
         [[nodiscard]] uint8_t GetHapticQueueSize(int8_t haptic) const { return Haptics[haptic].GetHapticQueueSize(); }
         void RemoveHapticCommand(int8_t haptic, int8_t commandIndex) { Haptics[haptic].RemoveHapticCommand(commandIndex); }
         void ClearHapticCommands() { for (auto& haptic : Haptics) haptic.ClearHapticCommands(); }
+        [[nodiscard]] bool HasHapticCommands() const;
         void AddHapticCommand(Tiny::Collections::TIFixedSpan<uint8_t> data);
 
         uint8_t Id = 0;
 
         void Reset();
+        /** Overrides the debouncing of an input set by ButtonDebounceDepth and ButtonDebounceEager */
+        void SetDebounce(int8_t input, uint8_t depth, bool eager) { Inputs[input].SetDebounce(depth, eager); }
+        /** Overrides the decimation of an input set by InputDecimation */
+        void SetDecimation(int8_t input, InputDecimations decimation) { Inputs[input].SetDecimation(decimation); }
+        /** Tunes the Seesaw conversion delays of an input, for pads with a faster or slower firmware */
+        void SetSeesawDelays(int8_t input, uint16_t readDelay, uint16_t adcDelay)
+        { Inputs[input].SetSeesawDelays(readDelay, adcDelay); }
 
     private:
         TwoWire& I2C0;
+        I2CQueue& I2C0Queue;
+        DiscoveryService& Discovery;
         SoftWire& I2C1;
+        Profiler& Profile;
         std::array<HapticController, MaxHapticControllers> Haptics{};
         std::array<MpuController, MaxMpuControllers> Mpus{};
         std::array<InputController, MaxInputControllers> Inputs{};
         int8_t HatOffset = -1;
+        Tiny::Drivers::Input::TITinyConMpuFormats MpuFormat = Tiny::Drivers::Input::TITinyConMpuFormats::Half;
+        Snapshot Frame;
+
+        void UpdateSeesaws();
+        void SnapshotInputs();
+        void SnapshotMpus();
+        bool Calibrate(const BusCalibration& calibration);
     };
 }
@@ -0,0 +1,133 @@
+#include "GyroBias.h"
+
+#include "Storage.h"
+
+#include "Core/Math/TIMath.h"
+
+using LogGamepad = Tiny::TILogTarget<TinyCon::GamepadLogLevel>;
+
+namespace
+{
+    float GetVariance(const Tiny::Math::TIVector3F& sum, const Tiny::Math::TIVector3F& squares, float count)
+    {
+        // Of the length of the vector, the sum of the variances of its axis
+        auto variance = 0.0f;
+        for (int8_t i = 0; i < 3; ++i) variance += squares.Data[i] / count - (sum.Data[i] / count) * (sum.Data[i] / count);
+        return variance;
+    }
+}
+
+void TinyCon::GyroBias::Configure(uint32_t period)
+{
+    WindowLength = static_cast<uint16_t>(Tiny::Math::Max<uint32_t, uint32_t>(1000ul * MpuStillTime / period, 2));
+    Restart();
+}
+
+void TinyCon::GyroBias::Clear()
+{
+    Bins = {};
+    Changed = true;
+    Extended = false;
+    Restart();
+}
+
+void TinyCon::GyroBias::Update(const Tiny::Math::TIVector3F& angularVelocity, const Tiny::Math::TIVector3F& acceleration, float temperature)
+{
+    if (!WindowSize)
+    {
+        AngularVelocityReference = angularVelocity;
+        AccelerationReference = acceleration;
+        AngularVelocitySum = AngularVelocitySquares = AccelerationSum = AccelerationSquares = {};
+        TemperatureSum = 0;
+    }
+
+    for (int8_t i = 0; i < 3; ++i)
+    {
+        const auto w = angularVelocity.Data[i] - AngularVelocityReference.Data[i];
+        const auto a = acceleration.Data[i] - AccelerationReference.Data[i];
+        AngularVelocitySum.Data[i] += w;
+        AngularVelocitySquares.Data[i] += w * w;
+        AccelerationSum.Data[i] += a;
+        AccelerationSquares.Data[i] += a * a;
+    }
+    TemperatureSum += temperature;
+    if (++WindowSize < WindowLength) return;
+
+    // Windows follow each other without overlap, a still window right after a moving one is learned all the same
+    WindowSize = 0;
+    const float count = WindowLength;
+    if (GetVariance(AngularVelocitySum, AngularVelocitySquares, count) > MpuStillAngularVelocity * MpuStillAngularVelocity ||
+        GetVariance(AccelerationSum, AccelerationSquares, count) > MpuStillAcceleration * MpuStillAcceleration) return;
+
+    const Tiny::Math::TIVector3F bias = {AngularVelocityReference.X + AngularVelocitySum.X / count,
+                                         AngularVelocityReference.Y + AngularVelocitySum.Y / count,
+                                         AngularVelocityReference.Z + AngularVelocitySum.Z / count};
+    if (bias.X * bias.X + bias.Y * bias.Y + bias.Z * bias.Z > MaxBias * MaxBias) return;
+    Learn(bias, TemperatureSum / count);
+}
+
+void TinyCon::GyroBias::Learn(const Tiny::Math::TIVector3F& bias, float temperature)
+{
+    const auto bin = static_cast<int32_t>((temperature - MpuBiasMinTemperature) / MpuBiasTemperatureStep);
+    const auto index = Tiny::Math::Min<int32_t, int32_t>(Tiny::Math::Max<int32_t, int32_t>(bin, 0), BinCount - 1);
+    auto& learned = Bins[index];
+    if (learned.Weight < MaxWeight) ++learned.Weight;
+    const auto rate = 1.0f / learned.Weight;
+    for (int8_t i = 0; i < 3; ++i) learned.Bias.Data[i] += (bias.Data[i] - learned.Bias.Data[i]) * rate;
+
+    Extended |= learned.Weight == 1;
+    Changed = true;
+    ++StillCount;
+    LogGamepad::Debug("    Gyro bias at ", temperature, "C: (", bias.X, ", ", bias.Y, ", ", bias.Z, ")", Tiny::TIEndl);
+}
+
+Tiny::Math::TIVector3F TinyCon::GyroBias::Get(float temperature) const
+{
+    // Between the nearest learned bin centers below and above, or the nearest one beyond the outermost learned bin
+    const auto position = (temperature - MpuBiasMinTemperature) / MpuBiasTemperatureStep - 0.5f;
+    int8_t below = -1, above = -1;
+    for (int8_t i = 0; i < BinCount; ++i)
+    {
+        if (!Bins[i].Weight) continue;
+        if (i <= position) below = i;
+        else if (above < 0) above = i;
+    }
+
+    if (below < 0 && above < 0) return {};
+    if (below < 0) return Bins[above].Bias;
+    if (above < 0) return Bins[below].Bias;
+    const auto t = (position - below) / (above - below);
+    const auto& low = Bins[below].Bias;
+    const auto& high = Bins[above].Bias;
+    return {low.X + (high.X - low.X) * t, low.Y + (high.Y - low.Y) * t, low.Z + (high.Z - low.Z) * t};
+}
+
+void TinyCon::GyroBias::GetPath(char (&path)[12], int8_t controller)
+{
+    // One table per IMU position, a sensor swapped for another starts from the table of the one before it
+    const char name[] = "/gyrobias0";
+    static_assert(sizeof(name) <= sizeof(path));
+    for (std::size_t i = 0; i < sizeof(name); ++i) path[i] = name[i];
+    path[sizeof(name) - 2] = static_cast<char>('0' + controller);
+}
+
+bool TinyCon::GyroBias::Load(int8_t controller)
+{
+    char path[12];
+    GetPath(path, controller);
+    std::array<Bin, BinCount> stored{};
+    if (!Storage::Load(path, Magic, &stored, sizeof(stored))) return false;
+    for (const auto& bin : stored) if (bin.Weight > MaxWeight) return false;
+    Bins = stored;
+    Changed = Extended = false;
+    return true;
+}
+
+bool TinyCon::GyroBias::Save(int8_t controller)
+{
+    char path[12];
+    GetPath(path, controller);
+    // Flash that can't be written now won't be a moment later either, a failed save waits for the next change as well
+    Changed = Extended = false;
+    return Storage::Save(path, Magic, &Bins, sizeof(Bins));
+}
@@ -0,0 +1,80 @@
+#pragma once
+
+#include "Config.h"
+
+#include "Core/Math/TIVector.h"
+
+#include <Arduino.h>
+
+#include <array>
+#include <cstdint>
+
+namespace TinyCon
+{
+    /**
+     * Learns the gyroscope bias of one IMU while it lies still, and keeps it per temperature, since the bias of a MEMS
+     * gyroscope follows the temperature of the die. Samples are collected in windows of MpuStillTime, and a window in
+     * which neither angular velocity nor acceleration varied by more than the noise is taken as still: its mean angular
+     * velocity is the bias at its temperature. The bias at any temperature is interpolated between the nearest learned
+     * temperatures on either side. The table is persisted, so a known IMU is corrected from its first sample on.
+     */
+    class GyroBias
+    {
+    public:
+        // Bins of MpuBiasTemperatureStep °C from MpuBiasMinTemperature on, colder or warmer goes to the outermost bins
+        static constexpr int8_t BinCount = 16;
+        // The mean of a still window is averaged into its bin with at least 1 / MaxWeight, so the bias keeps following
+        static constexpr uint16_t MaxWeight = 16;
+        // A still window with more than about 10°/s is not a bias, but a turntable
+        static constexpr float MaxBias = 0.17f;
+
+        struct Bin
+        {
+            Tiny::Math::TIVector3F Bias = {};
+            uint16_t Weight = 0;
+        };
+
+        /** The period is the time between samples in us */
+        void Configure(uint32_t period);
+        /** Forgets the window being collected, e.g. when the sensor went away, the table is kept */
+        void Restart() { WindowSize = 0; }
+        /** Forgets everything learned */
+        void Clear();
+
+        /** Angular velocity in rad/s before the correction, acceleration in m/s², temperature in °C */
+        void Update(const Tiny::Math::TIVector3F& angularVelocity, const Tiny::Math::TIVector3F& acceleration, float temperature);
+        /** The bias to subtract at the temperature in rad/s, zero if nothing was learned yet */
+        [[nodiscard]] Tiny::Math::TIVector3F Get(float temperature) const;
+
+        /** Whether the table changed since it was last loaded or saved, and whether it learned a new temperature */
+        [[nodiscard]] bool IsChanged() const { return Changed; }
+        [[nodiscard]] bool IsExtended() const { return Extended; }
+        [[nodiscard]] uint32_t GetStillCount() const { return StillCount; }
+        [[nodiscard]] const Bin& GetBin(int8_t bin) const { return Bins[bin]; }
+
+        bool Load(int8_t controller);
+        bool Save(int8_t controller);
+
+    private:
+        static constexpr uint32_t Magic = 0x47420001;
+
+        std::array<Bin, BinCount> Bins{};
+        bool Changed = false;
+        bool Extended = false;
+        uint32_t StillCount = 0;
+
+        // Sums of the window relative to its first sample, which keeps the float sums of squares from cancelling out
+        uint16_t WindowLength = 1;
+        uint16_t WindowSize = 0;
+        Tiny::Math::TIVector3F AngularVelocityReference = {};
+        Tiny::Math::TIVector3F AccelerationReference = {};
+        Tiny::Math::TIVector3F AngularVelocitySum = {};
+        Tiny::Math::TIVector3F AngularVelocitySquares = {};
+        Tiny::Math::TIVector3F AccelerationSum = {};
+        Tiny::Math::TIVector3F AccelerationSquares = {};
+        float TemperatureSum = 0;
+
+        void Learn(const Tiny::Math::TIVector3F& bias, float temperature);
+        static void GetPath(char (&path)[12], int8_t controller);
+    };
+}
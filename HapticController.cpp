@@ -15,6 +15,11 @@ namespace
         wire.endTransmission();
     }
 
+    void WriteRegister(TinyCon::I2CQueue& queue, uint8_t address, uint8_t reg, uint8_t value)
+    {
+        queue.Write(address, {reg, value});
+    }
+
     template <typename TWire>
     void SetMode(TWire& wire, uint8_t address, uint8_t mode)
     {
@@ -41,38 +46,49 @@ namespace
     }
 }
 
-void TinyCon::DRV2605Controller::Init(TwoWire& wire)
+void TinyCon::DRV2605Controller::Init(I2CQueue& queue, DiscoveryService& discovery)
 {
     SoftwareMode = false;
-    I2C.Hardware = &wire;
-    Init();
+    I2C.Hardware = &queue;
+    Present = false;
+    InitState.Set(DeviceStates::Absent);
+    discovery.Watch(0x5A, InitState);
 }
 
 void TinyCon::DRV2605Controller::Init(SoftWire& wire)
 {
     SoftwareMode = true;
     I2C.Software = &wire;
-    Init();
+    Present = false;
+    InitState.Set(DeviceStates::Absent);
 }
 
-void TinyCon::DRV2605Controller::Init()
+void TinyCon::DRV2605Controller::UpdateInit()
 {
-    if (SoftwareMode)
-    {
-        I2C.Software->beginTransmission(0x5A);
-        Present = I2C.Software->endTransmission() == 0;
-    }
-    else
-    {
-        I2C.Hardware->beginTransmission(0x5A);
-        Present = I2C.Hardware->endTransmission() == 0;
-    }
+    // The discovery service saw the DRV2605 depart
+    if (Present && !InitState.Is(DeviceStates::Present)) Present = false;
+    if (Present || !InitState.Ready()) return;
 
-    if (Present)
+    switch (InitState.State)
     {
-        Mode = DRV2605_MODE_INTTRIG;
-        if (SoftwareMode) InitDRV2605(*I2C.Software, Mode);
-        else InitDRV2605(*I2C.Hardware, Mode);
+        case DeviceStates::Absent:
+            // The software bus is not watched by the discovery service, so it still probes on its own
+            if (!SoftwareMode) break;
+            I2C.Software->beginTransmission(0x5A);
+            if (I2C.Software->endTransmission() == 0) InitState.Set(DeviceStates::Configuring);
+            else InitState.Lost();
+            break;
+        case DeviceStates::Probing:
+        case DeviceStates::Configuring:
+            Mode = DRV2605_MODE_INTTRIG;
+            if (SoftwareMode) InitDRV2605(*I2C.Software, Mode);
+            else InitDRV2605(*I2C.Hardware, Mode);
+            InitState.Set(DeviceStates::Present);
+            Present = true;
+            break;
+        default:
+            InitState.Lost();
+            break;
     }
 }
 
@@ -138,16 +154,25 @@ void TinyCon::DRV2605Controller::Stop()
     }
 }
 
-void TinyCon::HapticController::Init(TwoWire& wire)
+void TinyCon::HapticController::Init(I2CQueue& queue, DiscoveryService& discovery)
 {
-    DRV2605.Init(wire);
-    Present = DRV2605.Present;
+    DRV2605.Init(queue, discovery);
+    Present = false;
 }
 
 void TinyCon::HapticController::Init(SoftWire& wire)
 {
     DRV2605.Init(wire);
+    Present = false;
+}
+
+void TinyCon::HapticController::UpdateInit()
+{
+    if (!Enabled) return;
+    DRV2605.UpdateInit();
+    if (Present == DRV2605.Present) return;
     Present = DRV2605.Present;
+    LogHaptic::Info(Present ? "Haptic: DRV2605 initialized" : "Haptic: DRV2605 lost", Tiny::TIEndl);
 }
 
 void TinyCon::HapticController::Insert(uint8_t command, uint8_t count, const uint8_t* data, uint16_t duration)
@@ -167,13 +192,6 @@ void TinyCon::HapticController::Insert(uint8_t command, uint8_t count, const uin
 void TinyCon::HapticController::Update(int32_t deltaTime)
 {
     LogHaptic::Info("Haptic");
-    if (!Present && Enabled)
-    {
-        LogHaptic::Info(", Trying Init");
-        DRV2605.Init(Wire);
-        if ((Present = DRV2605.Present)) LogHaptic::Info(", Success");
-        else LogHaptic::Info(", Failed");
-    }
 
     if (HasNewCommand(deltaTime))
     {
@@ -2,6 +2,8 @@
 
 #include "Config.h"
 
+#include "Discovery.h"
+#include "I2CQueue.h"
 #include "Utilities.h"
 #include "Core/Drivers/Input/TITinyConTypes.h"
 
@@ -17,20 +19,24 @@ namespace TinyCon
         static constexpr uint8_t DRV2605_MODE_INTTRIG = 0x00;
         static constexpr uint8_t DRV2605_MODE_REALTIME = 0x05;
 
-        void Init(TwoWire& wire);
+        void Init(I2CQueue& queue, DiscoveryService& discovery);
         void Init(SoftWire& wire);
+        /** Advances the bring-up while the DRV2605 is not present, one step per call */
+        void UpdateInit();
         void PlayRealtime(uint8_t value);
         void PlayWaveform(const uint8_t* data);
         void Stop();
+        /** The status register, empty on the software bus, which doesn't have profiles */
+        [[nodiscard]] BusCalibration GetCalibration() const { return SoftwareMode ? BusCalibration{} : BusCalibration{0x5A, {0x00}, 1, 1}; }
 
         bool Present = false;
 
     private:
         uint8_t Mode = DRV2605_MODE_INTTRIG;
-        union { TwoWire* Hardware; SoftWire* Software; } I2C;
+        // Writes on the hardware bus are queued, the software bus has no DMA to offload to and stays blocking
+        union { I2CQueue* Hardware; SoftWire* Software; } I2C;
         bool SoftwareMode = false;
-
-        void Init();
+        DeviceInit InitState;
     };
 
     class HapticController
@@ -38,8 +44,11 @@ namespace TinyCon
     public:
         static constexpr int8_t MaxCommandCount = 8;
 
-        void Init(TwoWire& wire);
+        void Init(I2CQueue& queue, DiscoveryService& discovery);
         void Init(SoftWire& wire);
+        /** Initializes the DRV2605 while it is not present and notices it leaving, never blocks on a missing device */
+        void UpdateInit();
+        [[nodiscard]] BusCalibration GetCalibration() const { return Present ? DRV2605.GetCalibration() : BusCalibration{}; }
         void Insert(uint8_t command, uint8_t count, const uint8_t* data, uint16_t duration);
         void Update(int32_t deltaTime);
 
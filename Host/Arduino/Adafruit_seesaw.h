@@ -0,0 +1,32 @@
+#pragma once
+
+#include <Wire.h>
+
+enum { SEESAW_STATUS_BASE = 0x00, SEESAW_GPIO_BASE = 0x01, SEESAW_ADC_BASE = 0x09 };
+enum { SEESAW_STATUS_HW_ID = 0x01, SEESAW_STATUS_SWRST = 0x7F };
+enum { SEESAW_GPIO_DIRSET_BULK = 0x02, SEESAW_GPIO_DIRCLR_BULK = 0x03, SEESAW_GPIO_BULK = 0x04, SEESAW_GPIO_BULK_SET = 0x05,
+       SEESAW_GPIO_INTENSET = 0x08, SEESAW_GPIO_INTENCLR = 0x09, SEESAW_GPIO_INTFLAG = 0x0A, SEESAW_GPIO_PULLENSET = 0x0B };
+enum { SEESAW_ADC_CHANNEL_OFFSET = 0x07 };
+
+/** Present whenever the address acknowledges, all buttons released and the sticks centered */
+class Adafruit_seesaw
+{
+public:
+    Adafruit_seesaw(TwoWire* wire = nullptr) : Wire(wire) {}
+
+    bool begin(uint8_t address = 0x49, int8_t = -1, bool = true)
+    {
+        Wire->beginTransmission(address);
+        return Wire->endTransmission() == 0;
+    }
+    bool SWReset() { return true; }
+    void pinModeBulk(uint32_t, uint8_t) {}
+    void setGPIOInterrupts(uint32_t, bool) {}
+    uint32_t digitalReadBulk(uint32_t mask) { return mask; }
+    uint16_t analogRead(uint8_t) { return 512; }
+    bool read(uint8_t, uint8_t, uint8_t* data, uint8_t size, uint16_t = 250) { std::memset(data, 0, size); return true; }
+    bool write(uint8_t, uint8_t, uint8_t*, uint8_t) { return true; }
+
+private:
+    TwoWire* Wire;
+};
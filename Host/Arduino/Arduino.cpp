@@ -0,0 +1,44 @@
+#include "Arduino.h"
+
+#include <array>
+#include <chrono>
+#include <thread>
+
+HardwareSerial Serial;
+
+namespace
+{
+    const auto StartTime = std::chrono::steady_clock::now();
+    std::array<int, TinyCon::Host::MaxPins> DigitalPins = [] { std::array<int, TinyCon::Host::MaxPins> pins{}; pins.fill(HIGH); return pins; }();
+    std::array<int, TinyCon::Host::MaxPins> AnalogPins = [] { std::array<int, TinyCon::Host::MaxPins> pins{}; pins.fill(512); return pins; }();
+    std::array<void (*)(), TinyCon::Host::MaxPins> InterruptHandlers{};
+
+    bool IsValidPin(int pin) { return pin >= 0 && pin < TinyCon::Host::MaxPins; }
+}
+
+uint32_t millis()
+{
+    return std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - StartTime).count();
+}
+
+uint32_t micros()
+{
+    return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - StartTime).count();
+}
+
+void delay(uint32_t ms) { std::this_thread::sleep_for(std::chrono::milliseconds(ms)); }
+void delayMicroseconds(uint32_t us) { std::this_thread::sleep_for(std::chrono::microseconds(us)); }
+
+void pinMode(int, int) {}
+int digitalRead(int pin) { return IsValidPin(pin) ? DigitalPins[pin] : LOW; }
+void digitalWrite(int pin, int value) { if (IsValidPin(pin)) DigitalPins[pin] = value; }
+int analogRead(int pin) { return IsValidPin(pin) ? AnalogPins[pin] : 0; }
+void analogWrite(int, int) {}
+void analogReference(int) {}
+
+void attachInterrupt(int interrupt, void (*handler)(), int) { if (IsValidPin(interrupt)) InterruptHandlers[interrupt] = handler; }
+void detachInterrupt(int interrupt) { if (IsValidPin(interrupt)) InterruptHandlers[interrupt] = nullptr; }
+
+void TinyCon::Host::SetDigitalPin(int pin, int value) { if (IsValidPin(pin)) DigitalPins[pin] = value; }
+void TinyCon::Host::SetAnalogPin(int pin, int value) { if (IsValidPin(pin)) AnalogPins[pin] = value; }
+void TinyCon::Host::RaiseInterrupt(int pin) { if (IsValidPin(pin) && InterruptHandlers[pin]) InterruptHandlers[pin](); }
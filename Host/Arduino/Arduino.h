@@ -0,0 +1,76 @@
+#pragma once
+
+/**
+ * Thin stand-in for the parts of the Arduino API the firmware uses, so its pure logic can be built and measured on a
+ * Linux host. Time comes from the host's steady clock, pins are plain arrays that host code can set through
+ * TinyCon::Host, everything else does nothing.
+ */
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+#define HEX 16
+#define DEC 10
+#define OCT 8
+#define BIN 2
+
+#define LOW 0
+#define HIGH 1
+#define INPUT 0
+#define OUTPUT 1
+#define INPUT_PULLUP 2
+#define INPUT_PULLDOWN 3
+#define CHANGE 1
+#define FALLING 2
+#define RISING 3
+
+#define A0 14
+#define A1 15
+#define A2 16
+#define A3 17
+#define A4 18
+#define A5 19
+#define A6 20
+#define A7 21
+#define AR_INTERNAL_3_0 1
+
+#define SERIAL_BUFFER_SIZE 64
+
+class HardwareSerial
+{
+public:
+    void begin(unsigned long) {}
+    template <typename ...TValues> std::size_t print(TValues...) { return 0; }
+    template <typename ...TValues> std::size_t println(TValues...) { return 0; }
+    explicit operator bool() const { return true; }
+};
+
+extern HardwareSerial Serial;
+
+uint32_t millis();
+uint32_t micros();
+void delay(uint32_t ms);
+void delayMicroseconds(uint32_t us);
+
+void pinMode(int pin, int mode);
+int digitalRead(int pin);
+void digitalWrite(int pin, int value);
+int analogRead(int pin);
+void analogWrite(int pin, int value);
+void analogReference(int reference);
+
+inline int digitalPinToInterrupt(int pin) { return pin; }
+void attachInterrupt(int interrupt, void (*handler)(), int mode);
+void detachInterrupt(int interrupt);
+
+namespace TinyCon::Host
+{
+    constexpr int MaxPins = 48;
+
+    /** Pins read back what was set here, digital pins default to HIGH to look like released buttons with pull-ups */
+    void SetDigitalPin(int pin, int value);
+    void SetAnalogPin(int pin, int value);
+    /** Calls the handler attached to the pin, if any */
+    void RaiseInterrupt(int pin);
+}
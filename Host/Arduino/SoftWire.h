@@ -0,0 +1,13 @@
+#pragma once
+
+#include <Wire.h>
+
+/** The bit-banged bus behaves the same as Wire on the host */
+class SoftWire : public TwoWire
+{
+public:
+    SoftWire(uint8_t, uint8_t) {}
+    void setTimeout_ms(int) {}
+    void setRxBuffer(uint8_t*, std::size_t) {}
+    void setTxBuffer(uint8_t*, std::size_t) {}
+};
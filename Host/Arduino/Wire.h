@@ -0,0 +1,53 @@
+#pragma once
+
+#include <Arduino.h>
+
+#include "Host/MockI2CBus.h"
+
+/** Blocking Wire on top of a mock bus, devices answer once they were added to GetMockBus() */
+class TwoWire
+{
+public:
+    void begin() {}
+    void begin(uint8_t) {}
+    void setClock(uint32_t clock) { Bus.SetClock(clock); }
+    void setTimeout(int) {}
+
+    void beginTransmission(uint8_t address) { Address = address; TxSize = 0; }
+    std::size_t write(uint8_t value) { if (TxSize == sizeof(Tx)) return 0; Tx[TxSize++] = value; return 1; }
+    std::size_t write(const uint8_t* data, std::size_t size) { std::size_t i = 0; for (; i < size && write(data[i]); ++i); return i; }
+    uint8_t endTransmission(bool = true)
+    {
+        Bus.Start(Address, Tx, TxSize, nullptr, 0);
+        return Bus.Resolve(Address).Present ? 0 : 2;
+    }
+
+    uint8_t requestFrom(uint8_t address, uint8_t size, bool = true)
+    {
+        RxSize = RxHead = 0;
+        if (size > sizeof(Rx)) size = sizeof(Rx);
+        Bus.Start(address, nullptr, 0, Rx, size);
+        if (!Bus.Resolve(address).Present) return 0;
+        return RxSize = size;
+    }
+    int available() const { return RxSize - RxHead; }
+    int read() { return RxHead < RxSize ? Rx[RxHead++] : -1; }
+    std::size_t readBytes(uint8_t* data, std::size_t size) { std::size_t i = 0; for (; i < size && available(); ++i) data[i] = read(); return i; }
+
+    void onRequest(void (*)()) {}
+    void onReceive(void (*)(int)) {}
+
+    TinyCon::Host::MockI2CBus& GetMockBus() { return Bus; }
+
+private:
+    TinyCon::Host::MockI2CBus Bus;
+    uint8_t Address = 0;
+    uint8_t Tx[SERIAL_BUFFER_SIZE] = {};
+    uint8_t TxSize = 0;
+    uint8_t Rx[SERIAL_BUFFER_SIZE] = {};
+    uint8_t RxSize = 0;
+    uint8_t RxHead = 0;
+};
+
+extern TwoWire Wire;
+extern TwoWire Wire1;
@@ -0,0 +1,24 @@
+#pragma once
+
+#include <Arduino.h>
+
+// Only the HID report layout, the Bluetooth stack itself is not part of host builds
+typedef struct
+{
+    int8_t x, y, z, rz, rx, ry;
+    uint8_t hat;
+    uint32_t buttons;
+} hid_gamepad_report_t;
+
+enum
+{
+    GAMEPAD_HAT_CENTERED = 0,
+    GAMEPAD_HAT_UP,
+    GAMEPAD_HAT_UP_RIGHT,
+    GAMEPAD_HAT_RIGHT,
+    GAMEPAD_HAT_DOWN_RIGHT,
+    GAMEPAD_HAT_DOWN,
+    GAMEPAD_HAT_DOWN_LEFT,
+    GAMEPAD_HAT_LEFT,
+    GAMEPAD_HAT_UP_LEFT
+};
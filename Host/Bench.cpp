@@ -0,0 +1,684 @@
+/**
+ * Host-side microbenchmarks for the per-frame path of the firmware, built against the fake Arduino layer in
+ * Host/Arduino. Each benchmark reports the time per operation and the heap allocations per operation as JSON, in a
+ * fixed order and format, so two runs can be diffed directly. Before that it checks that the I2C queue keeps its order
+ * and the bus timing, that the devices came up and read their own data, that the axis config window and the axis
+ * processing give the documented values, that the report filters and their Profile window entries work, that buttons
+ * are debounced as documented and that the orientation filter converges, and fails otherwise.
+ * Usage: bench [--min-time-ms N] [filter]
+ */
+
+#include "AxisProcessor.h"
+#include "CommandProcessor.h"
+#include "Discovery.h"
+#include "GamepadController.h"
+#include "GyroBias.h"
+#include "HapticController.h"
+#include "I2CQueue.h"
+#include "InputController.h"
+#include "MpuEncoder.h"
+#include "OrientationFilter.h"
+#include "Power.h"
+#include "Profiler.h"
+#include "ReportFilter.h"
+
+#include "Core/Math/TIMath.h"
+
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <new>
+#include <vector>
+
+TwoWire Wire;
+TwoWire Wire1;
+
+namespace
+{
+    std::size_t AllocationCount = 0;
+}
+
+void* operator new(std::size_t size)
+{
+    ++AllocationCount;
+    if (auto* memory = std::malloc(size ? size : 1)) return memory;
+    throw std::bad_alloc();
+}
+void* operator new[](std::size_t size) { return operator new(size); }
+void operator delete(void* memory) noexcept { std::free(memory); }
+void operator delete[](void* memory) noexcept { std::free(memory); }
+void operator delete(void* memory, std::size_t) noexcept { std::free(memory); }
+void operator delete[](void* memory, std::size_t) noexcept { std::free(memory); }
+
+namespace
+{
+    using Clock = std::chrono::steady_clock;
+
+    template <typename TValue>
+    inline void DoNotOptimize(const TValue& value) { asm volatile("" : : "m"(value) : "memory"); }
+
+    struct Result
+    {
+        const char* Name;
+        uint64_t Iterations;
+        double NsPerOp;
+        double AllocsPerOp;
+    };
+
+    struct Options
+    {
+        uint32_t MinTimeMs = 200;
+        const char* Filter = nullptr;
+    };
+
+    template <typename TFunction>
+    double Time(TFunction& function, uint64_t iterations)
+    {
+        const auto start = Clock::now();
+        for (uint64_t i = 0; i < iterations; ++i) function();
+        return std::chrono::duration<double, std::nano>(Clock::now() - start).count();
+    }
+
+    template <typename TFunction>
+    void Run(std::vector<Result>& results, const Options& options, const char* name, TFunction function)
+    {
+        if (options.Filter && !std::strstr(name, options.Filter)) return;
+
+        // Warm up and grow the iteration count until a run takes a tenth of the target time, then scale it up
+        uint64_t iterations = 1;
+        for (double elapsed = 0; elapsed < options.MinTimeMs * 1e5 && iterations < (1ull << 40); iterations *= 2)
+            elapsed = Time(function, iterations);
+        iterations *= 10;
+
+        const auto allocations = AllocationCount;
+        const auto elapsed = Time(function, iterations);
+        results.push_back({name, iterations, elapsed / iterations, static_cast<double>(AllocationCount - allocations) / iterations});
+    }
+
+    /**
+     * Every configured ICM20948 and Seesaw pad, a DRV2605 on each bus and the native pins, like a fully equipped
+     * controller. With a mux the pads and IMUs sit on its channels in order, same as the firmware expects them.
+     */
+    struct Fixture
+    {
+        SoftWire I2C1{0, 1};
+        TinyCon::Profiler Profile;
+        TinyCon::I2CQueue Queue{Wire};
+        TinyCon::DiscoveryService Discovery{Queue};
+        TinyCon::GamepadController Controller{Wire, Queue, Discovery, I2C1, Profile};
+        TinyCon::PowerController Power{Wire};
+        TinyCon::Scheduler Tasks;
+        TinyCon::CommandProcessor Processor{Controller, Power, Profile, Tasks};
+        // Added to the profiler like the transports add theirs
+        TinyCon::GamepadReportFilter GamepadFilter;
+        TinyCon::MpuReportFilter MpuFilter;
+
+        Fixture()
+        {
+            Profile.AddReportFilter(GamepadFilter);
+            Profile.AddReportFilter(MpuFilter);
+            // The queue runs on the mock bus of Wire, so the Seesaw bring-up, which talks to Wire directly, only finds
+            // a pad behind the mux if the driver selected its channel first
+            auto& bus = Queue.GetMockBus();
+            if (TinyCon::I2CMuxChannelCount > 0) bus.SetMux(TinyCon::I2CMuxAddress);
+            bus.AddDevice(0x5A);
+            for (int8_t i = 0; i < TinyCon::MpuController::MaxControllers; ++i)
+            {
+                const auto address = TinyCon::MpuController::GetAddress(i);
+                bus.AddDevice(TinyCon::GetI2CBusAddress(address), TinyCon::GetI2CChannel(address));
+                // The mock has no banks or FIFO, WHO_AM_I answers, the count register claims five samples and the burst
+                // reads on from there, the magnetometer always has a new reading. Every IMU has samples of its own, so
+                // one read on another IMU's channel shows.
+                auto& device = bus.GetDevice(TinyCon::GetI2CBusAddress(address), TinyCon::GetI2CChannel(address));
+                device.Registers[0x00] = 0xEA;
+                device.Registers[0x3B] = 0x01;
+                for (int j = 1; j < 7; ++j) device.Registers[0x3B + j] = static_cast<uint8_t>(j * 53);
+                device.Registers[0x71] = 5 * 14;
+                for (int j = 0; j < 5 * 14; ++j) device.Registers[0x72 + j] = static_cast<uint8_t>(j * 37 + i);
+            }
+            // All buttons released and the sticks at full scale
+            for (int8_t i = 0; i < TinyCon::SeesawController::MaxControllers; ++i)
+            {
+                const auto address = TinyCon::SeesawController::GetAddress(i);
+                auto& device = bus.GetDevice(TinyCon::GetI2CBusAddress(address), TinyCon::GetI2CChannel(address));
+                device.Present = true;
+                device.Registers.fill(0xFF);
+            }
+            // Only the queue overhead should be measured, not the simulated bus time
+            bus.SetInstant(true);
+            I2C1.GetMockBus().AddDevice(0x5A);
+
+            Profile.Init();
+            Controller.Init(0, {A0, A1, A2, A3, A4, A5}, {5, 6, 9, 10, 11, 12, 13}, TinyCon::ActiveState::Low);
+            // Measure the driver, not the Seesaw's conversion time
+            for (int8_t i = 0; i < TinyCon::SeesawController::MaxControllers; ++i) Controller.SetSeesawDelays(i, 0, 0);
+
+            // Device bring-up waits in real time and the discovery sweep takes longer with every mux channel
+            for (const auto start = millis(); millis() - start < 1000 * (TinyCon::I2CMuxChannelCount + 1);)
+            {
+                Discovery.Update();
+                Controller.UpdateDevices();
+                Queue.Update();
+                if (IsComplete()) break;
+                delay(1);
+            }
+            Controller.UpdateInputs();
+            Controller.DecimateInputs();
+            Controller.UpdateMpus();
+            Processor.Init();
+        }
+
+        [[nodiscard]] bool IsComplete() const
+        {
+            for (int8_t i = 0; i < TinyCon::MpuController::MaxControllers; ++i) if (!Controller.GetMpuPresent(i)) return false;
+            for (int8_t i = 0; i < TinyCon::SeesawController::MaxControllers; ++i) if (!Controller.GetInputPresent(i)) return false;
+            return true;
+        }
+
+        /** Whether every IMU drained the samples of its own device, and not those of whatever channel was selected */
+        [[nodiscard]] bool IsRouted()
+        {
+            for (int8_t i = 0; i < TinyCon::MpuController::MaxControllers; ++i)
+            {
+                const auto address = TinyCon::MpuController::GetAddress(i);
+                const auto& device = Queue.GetMockBus().GetDevice(TinyCon::GetI2CBusAddress(address), TinyCon::GetI2CChannel(address));
+                const auto& mpu = Controller.GetMpu(i);
+                if (!mpu.GetBatchSize() || mpu.GetSample(0).Acceleration.X != static_cast<int16_t>(device.Registers[0x72] << 8 | device.Registers[0x73]))
+                    return false;
+            }
+            return true;
+        }
+
+        /**
+         * Whether the AxisConfig window configures the selected axis and reads it back, and refuses an axis that
+         * doesn't exist. Leaves the first axis configured as before.
+         */
+        [[nodiscard]] bool IsAxisConfigurable()
+        {
+            constexpr auto axisConfig = static_cast<uint8_t>(Tiny::Drivers::Input::TITinyConCommands::AxisConfig);
+            auto* axis = Controller.GetAxisProcessor(0);
+            if (!axis) return false;
+            const auto previous = axis->GetConfig();
+
+            // Bit 7 forgets the calibration and is not kept in the flags
+            const uint8_t configure[] = {axisConfig, 0, TinyCon::AxisConfig::Invert | 0x80, 16, 4, 128, 32};
+            if (!Processor.ProcessCommand({configure, sizeof(configure)}) ||
+                Processor.LastCommandStatus != Tiny::Drivers::Input::TITinyConCommandStatus::Ok)
+                return false;
+            const auto& config = axis->GetConfig();
+            if (config.Flags != TinyCon::AxisConfig::Invert || config.Deadzone != 16 || config.OuterDeadzone != 4 || config.Curve != 128 ||
+                config.Filter != 32)
+                return false;
+            const auto* window = &Processor.Registers[axisConfig];
+            if (window[0] != 0 || window[1] != Controller.GetAxisCount() || window[2] != TinyCon::AxisConfig::Invert || window[3] != 16 ||
+                window[4] != 4 || window[5] != 128 || window[6] != 32)
+                return false;
+            const uint16_t center = axis->GetCenter();
+            if (window[7] != center >> 8 || window[8] != (center & 0xFF)) return false;
+
+            const uint8_t invalid[] = {axisConfig, static_cast<uint8_t>(Controller.GetAxisCount())};
+            Processor.ProcessCommand({invalid, sizeof(invalid)});
+            if (Processor.LastCommandStatus != Tiny::Drivers::Input::TITinyConCommandStatus::ErrorInvalidAxisIndex || window[0] != 0xFF ||
+                window[2] != 0xFF)
+                return false;
+
+            const uint8_t restore[] = {axisConfig, 0, previous.Flags, previous.Deadzone, previous.OuterDeadzone, previous.Curve, previous.Filter};
+            Processor.ProcessCommand({restore, sizeof(restore)});
+            return Processor.LastCommandStatus == Tiny::Drivers::Input::TITinyConCommandStatus::Ok;
+        }
+
+        /**
+         * Whether the MPU filter passes over the timestamp and magnetometer count and only lets a value change through,
+         * and whether the Profile window shows the counts and thresholds of the filters and clears the counts. Leaves
+         * the window on the first stage.
+         */
+        [[nodiscard]] bool IsReportFilterProfiled()
+        {
+            constexpr auto profile = static_cast<uint8_t>(Tiny::Drivers::Input::TITinyConCommands::Profile);
+            const auto* window = &Processor.Registers[profile];
+            const auto select = [this](int stage, uint8_t confirm = 0)
+            {
+                const uint8_t data[] = {profile, static_cast<uint8_t>(stage), confirm};
+                Processor.ProcessCommand({data, confirm ? sizeof(data) : sizeof(data) - 1});
+            };
+            const auto half = [window](uint8_t offset, float value)
+            {
+                const auto expected = Tiny::Math::HalfFromFloat(value);
+                return window[offset] == expected >> 8 && window[offset + 1] == (expected & 0xFF);
+            };
+
+            // Acceleration as 3 halves, then the timestamp and the magnetometer count
+            constexpr uint8_t fields = 0x08 | 0x20 | 0x40;
+            uint8_t report[6 + TinyCon::MpuController::TimestampSize + TinyCon::MpuController::MagnetometerCountSize] = {};
+            if (!MpuFilter.IsDue({report, sizeof(report)}, fields, 0)) return false;
+            MpuFilter.Sent({report, sizeof(report)}, fields, 0);
+            for (std::size_t i = 6; i < sizeof(report); ++i) report[i] = 0x7C;
+            if (MpuFilter.IsDue({report, sizeof(report)}, fields, 1)) return false;
+            const auto acceleration = Tiny::Math::HalfFromFloat(1);
+            report[0] = acceleration & 0xFF;
+            report[1] = acceleration >> 8;
+            if (!MpuFilter.IsDue({report, sizeof(report)}, fields, 2)) return false;
+
+            select(Tiny::Drivers::Input::TITinyConProfileFilterBase + 1);
+            if (window[0] != Tiny::Drivers::Input::TITinyConProfileFilterBase + 1 || window[1] != 2 || window[5] != 1 || window[9] != 1 ||
+                window[10] != TinyCon::ReportKeepAlive >> 8 || window[11] != (TinyCon::ReportKeepAlive & 0xFF) || window[12] != 1)
+                return false;
+            select(Tiny::Drivers::Input::TITinyConProfileThresholdBase);
+            if (!half(2, TinyCon::ReportAxisThreshold) || window[4] != 0xFF || window[11] != 0xFF) return false;
+            select(Tiny::Drivers::Input::TITinyConProfileThresholdBase + 1);
+            if (!half(2, TinyCon::ReportAccelerationThreshold) || !half(8, TinyCon::ReportTemperatureThreshold) ||
+                !half(10, TinyCon::ReportQuaternionThreshold))
+                return false;
+            select(Tiny::Drivers::Input::TITinyConProfileFilterBase + 2);
+            if (window[0] != 0xFF || window[2] != 0xFF) return false;
+            select(Tiny::Drivers::Input::TITinyConProfileFilterBase + 1, Tiny::Drivers::Input::TITinyConResetConfirm);
+            if (window[5] != 0 || window[9] != 0) return false;
+            select(0);
+            return window[0] == 0;
+        }
+    };
+
+    /**
+     * Whether the queue runs its transactions in the order they were queued, retries a failed one in its place, and
+     * keeps the bus busy for as long as the mock bus takes to clock them out at 400kHz. Runs on Wire's mock bus before
+     * the fixture makes it instant.
+     */
+    bool IsQueueOrdered()
+    {
+        auto& bus = Wire.GetMockBus();
+        bus.AddDevice(0x20);
+        bus.ClearTrace();
+        TinyCon::I2CQueue queue{Wire};
+        uint8_t rx[3] = {};
+        uint8_t absent[2] = {};
+        queue.Write(0x20, {0x10, 1, 2, 3});
+        queue.WriteRead(0x20, {0x10}, rx, sizeof(rx));
+        queue.Read(0x21, absent, sizeof(absent));
+        queue.Flush();
+        bus.GetDevice(0x20).Present = false;
+
+        // The absent device is tried once more, the default profile has a retry
+        const TinyCon::Host::MockI2CBus::TraceEntry expected[] = {
+            {0x20, 4, 0, 0x10, true}, {0x20, 1, 3, 0x10, true}, {0x21, 0, 2, 0, false}, {0x21, 0, 2, 0, false}};
+        constexpr auto count = sizeof(expected) / sizeof(expected[0]);
+        if (bus.GetTraceCount() != count) return false;
+        for (uint32_t i = 0; i < count; ++i)
+        {
+            const auto& entry = bus.GetTrace(i);
+            if (entry.Address != expected[i].Address || entry.TxSize != expected[i].TxSize || entry.RxSize != expected[i].RxSize ||
+                entry.Register != expected[i].Register || entry.Success != expected[i].Success)
+                return false;
+        }
+        if (rx[0] != 1 || rx[1] != 2 || rx[2] != 3) return false;
+        if (queue.GetCompletedCount() != 2 || queue.GetFailedCount() != 1 || queue.GetByteCount() != 8) return false;
+
+        // 9 clocks a byte with the address bytes, plus start and stop, at 400kHz: 117us, 140us and twice 72us
+        constexpr uint32_t busyTime = 117 + 140 + 2 * 72;
+        return queue.GetBusyTime() >= busyTime && queue.GetBusyTime() < 2 * busyTime + 1000;
+    }
+
+    /** Whether both debouncer modes report presses, releases and bounces at ButtonDebounceDepth as documented */
+    bool IsDebouncing()
+    {
+        constexpr auto depth = TinyCon::ButtonDebounceDepth;
+
+        // Eager reports the press right away and ignores the button for the next Depth samples, whatever it reads
+        TinyCon::ButtonDebouncer eager;
+        eager.Configure(depth, true);
+        if (eager.Update(1) != 1) return false;
+        for (uint8_t i = 0; i < depth; ++i) if (eager.Update(i & 1) != 1) return false;
+        if (eager.Update(0) != 0) return false;
+        for (uint8_t i = 0; i < depth; ++i) if (eager.Update(~i & 1) != 0) return false;
+        // A locked button doesn't hold up the others
+        if (eager.Update(1) != 1 || eager.Update(3) != 3) return false;
+
+        // Integrating reports a change once it read the same for Depth samples, a bounce starts the count over
+        TinyCon::ButtonDebouncer integrating;
+        integrating.Configure(depth, false);
+        for (uint8_t i = 1; i < depth; ++i) if (integrating.Update(1) != 0) return false;
+        if (integrating.Update(1) != 1) return false;
+        for (uint8_t i = 1; i < depth; ++i) if (integrating.Update(0) != 1) return false;
+        if (integrating.Update(1) != 1) return false;
+        for (uint8_t i = 1; i < depth; ++i) if (integrating.Update(0) != 1) return false;
+        return integrating.Update(0) == 0;
+    }
+
+    /**
+     * Whether the axis processing gives the documented values at the edges: nothing up to the deadzone and just
+     * above it, full scale at both ends, the cubic curve at half scale, and inversion and calibration saturating.
+     */
+    bool IsAxisShaping()
+    {
+        constexpr int16_t max = INT16_MAX;
+        constexpr int16_t min = INT16_MIN;
+
+        // Linear without deadzones passes everything, -1 is one count short of -32768 so both ends match
+        TinyCon::AxisProcessor linear;
+        linear.Configure({0, 0, 0, 0, 0});
+        if (linear.Shape(16384) != 16384 || linear.Shape(-12345) != -12345 || linear.Shape(max) != max || linear.Shape(min) != -max)
+            return false;
+
+        // 8/256 is 1024 in Q15, the rest is stretched back to full scale
+        TinyCon::AxisProcessor deadzone;
+        deadzone.Configure({0, 8, 0, 0, 0});
+        if (deadzone.Shape(1024) != 0 || deadzone.Shape(-1024) != 0 || deadzone.Shape(1025) != 1 || deadzone.Shape(-1025) != -1 ||
+            deadzone.Shape(max) != max || deadzone.Shape(min) != -max)
+            return false;
+        // Whatever is inside the outer deadzone is full scale
+        deadzone.Configure({0, 8, 8, 0, 0});
+        if (deadzone.Shape(max - 1024) != max || deadzone.Shape(-max + 1024) != -max) return false;
+        // The radial deadzone measures the stick vector, not each axis
+        int16_t x = 1000, y = 1000;
+        TinyCon::AxisProcessor::ApplyRadialDeadzone(deadzone, x, y);
+        if (x <= 0 || y <= 0 || x != y) return false;
+
+        // Cubic halves to an eighth and keeps both ends
+        TinyCon::AxisProcessor cubic;
+        cubic.Configure({0, 0, 0, 255, 0});
+        if (cubic.Shape(16384) != 4096 || cubic.Shape(-16384) != -4096 || cubic.Shape(max) != max || cubic.Shape(min) != -max) return false;
+
+        // Inversion alone saturates -32768 instead of overflowing
+        TinyCon::AxisProcessor inverted;
+        inverted.Configure({TinyCon::AxisConfig::Invert, 0, 0, 0, 0});
+        if (inverted.Calibrate(max) != -max || inverted.Calibrate(min) != max || inverted.Calibrate(100) != -100) return false;
+
+        // The first sample is the center, InitialRange to either side is full scale until the axis goes further
+        TinyCon::AxisProcessor calibrated;
+        calibrated.Configure({TinyCon::AxisConfig::Calibrate | TinyCon::AxisConfig::Invert, 0, 0, 0, 0});
+        constexpr int16_t center = 1000;
+        if (calibrated.Calibrate(center) != 0 || calibrated.Calibrate(center - TinyCon::AxisProcessor::InitialRange) != max ||
+            std::abs(calibrated.Calibrate(center + TinyCon::AxisProcessor::InitialRange) + max) > 1)
+            return false;
+        if (std::abs(calibrated.Calibrate(center + 20000) + max) > 1 || calibrated.GetMax() != center + 20000 ||
+            std::abs(calibrated.Calibrate(center + 10000) + max / 2) > 1)
+            return false;
+        return calibrated.GetCenter() == center && calibrated.Calibrate(max) == -max;
+    }
+
+    /** Angle in degrees between the gravity the filter expects in the sensor frame and the given one */
+    float GravityError(const TinyCon::OrientationFilter& fusion, float ax, float ay, float az)
+    {
+        const auto& q = fusion.GetOrientation();
+        const auto vx = 2 * (q.X * q.Z - q.W * q.Y), vy = 2 * (q.W * q.X + q.Y * q.Z), vz = q.W * q.W - q.X * q.X - q.Y * q.Y + q.Z * q.Z;
+        const auto cosine = (vx * ax + vy * ay + vz * az) / std::sqrt(ax * ax + ay * ay + az * az);
+        return std::acos(std::fmin(std::fmax(cosine, -1.0f), 1.0f)) * 57.29578f;
+    }
+
+    /** Heading of the sensor about the earth's Z in degrees, 0 with its X towards magnetic north */
+    float Heading(const TinyCon::OrientationFilter& fusion)
+    {
+        const auto& q = fusion.GetOrientation();
+        return std::atan2(2 * (q.W * q.Z + q.X * q.Y), 1 - 2 * (q.Y * q.Y + q.Z * q.Z)) * 57.29578f;
+    }
+
+    /**
+     * Whether the Mahony filter, with the firmware's gains, finds the orientation of a still sensor after it was
+     * levelled somewhere else, tilted or turned away from magnetic north, and whether it stays put at rest.
+     */
+    bool IsFusionConverging()
+    {
+        constexpr auto period = TinyCon::MpuController::SamplePeriod * 1e-6f;
+        const auto samples = static_cast<int>(1 / period);
+        constexpr float gravity = 9.81f;
+        const Tiny::Math::TIVector3F north = {20, 0, -40};
+
+        // Levelled flat, then tilted by 30 degrees about X
+        TinyCon::OrientationFilter tilt;
+        tilt.Configure(TinyCon::MpuFusionProportionalGain, TinyCon::MpuFusionIntegralGain, period);
+        tilt.Update({0, 0, gravity}, {}, {});
+        const auto tiltY = gravity * std::sin(0.5236f), tiltZ = gravity * std::cos(0.5236f);
+        for (int i = 0; i < samples * 20; ++i) tilt.Update({0, tiltY, tiltZ}, {}, {});
+        if (GravityError(tilt, 0, tiltY, tiltZ) > 0.1f) return false;
+
+        // Nothing to correct, nothing may move
+        TinyCon::OrientationFilter still;
+        still.Configure(TinyCon::MpuFusionProportionalGain, TinyCon::MpuFusionIntegralGain, period);
+        for (int i = 0; i < samples * 60; ++i)
+        {
+            still.Update({0, 0, gravity}, {}, north);
+            if (GravityError(still, 0, 0, 1) > 0.01f || std::fabs(Heading(still)) > 0.01f) return false;
+        }
+
+        // A biased gyroscope at rest, the integral has to learn the bias and take the orientation back
+        TinyCon::OrientationFilter biased;
+        biased.Configure(TinyCon::MpuFusionProportionalGain, 0.05f, period);
+        for (int i = 0; i < samples * 200; ++i)
+        {
+            biased.Update({0, 0, gravity}, {0.01f, -0.02f, 0.015f}, north);
+            if (GravityError(biased, 0, 0, 1) > 10 || std::fabs(Heading(biased)) > 10) return false;
+        }
+        const auto& integral = biased.GetIntegral();
+        if (GravityError(biased, 0, 0, 1) > 0.5f || std::fabs(Heading(biased)) > 0.5f ||
+            std::fabs(integral.X + 0.01f) > 0.0005f || std::fabs(integral.Y - 0.02f) > 0.0005f || std::fabs(integral.Z + 0.015f) > 0.0005f)
+            return false;
+
+        // Levelled facing north, while the field says the sensor faces 60 degrees further around Z. Only the
+        // horizontal part of the field corrects the heading, which makes it the slowest to settle.
+        TinyCon::OrientationFilter compass;
+        compass.Configure(TinyCon::MpuFusionProportionalGain, TinyCon::MpuFusionIntegralGain, period);
+        compass.Update({0, 0, gravity}, {}, {});
+        const Tiny::Math::TIVector3F turned = {north.X * std::cos(1.0472f), -north.X * std::sin(1.0472f), north.Z};
+        for (int i = 0; i < samples * 150; ++i) compass.Update({0, 0, gravity}, {}, turned);
+        return std::fabs(Heading(compass) - 60) < 0.5f && GravityError(compass, 0, 0, 1) < 0.1f;
+    }
+}
+
+int main(int argc, char** argv)
+{
+    Options options;
+    for (int i = 1; i < argc; ++i)
+    {
+        if (!std::strcmp(argv[i], "--min-time-ms") && i + 1 < argc) options.MinTimeMs = std::strtoul(argv[++i], nullptr, 10);
+        else options.Filter = argv[i];
+    }
+
+    if (!IsQueueOrdered())
+    {
+        std::fprintf(stderr, "The I2C queue did not run its transactions in order and at the bus clock\n");
+        return 1;
+    }
+
+    Fixture fixture;
+    if (!fixture.IsComplete())
+    {
+        std::fprintf(stderr, "Devices did not come up on the mock buses\n");
+        return 1;
+    }
+    if (!fixture.IsRouted())
+    {
+        std::fprintf(stderr, "IMUs read samples of other devices\n");
+        return 1;
+    }
+    if (!fixture.IsAxisConfigurable())
+    {
+        std::fprintf(stderr, "The axis config window did not configure or read back the axis\n");
+        return 1;
+    }
+    if (!fixture.IsReportFilterProfiled())
+    {
+        std::fprintf(stderr, "The report filters were misjudged or misreported in the Profile window\n");
+        return 1;
+    }
+    if (!IsDebouncing())
+    {
+        std::fprintf(stderr, "The button debouncer misreported a press, release or bounce\n");
+        return 1;
+    }
+    if (!IsAxisShaping())
+    {
+        std::fprintf(stderr, "The axis processing did not give the documented values at its edges\n");
+        return 1;
+    }
+    if (!IsFusionConverging())
+    {
+        std::fprintf(stderr, "The orientation filter did not converge\n");
+        return 1;
+    }
+
+    std::vector<Result> results;
+
+    float values[64];
+    for (int i = 0; i < 64; ++i) values[i] = (i - 32) * 0.37f;
+    int valueIndex = 0;
+    Run(results, options, "Math/HalfFromFloat", [&]
+        {
+            DoNotOptimize(Tiny::Math::HalfFromFloat(values[valueIndex]));
+            valueIndex = (valueIndex + 1) & 63;
+        });
+
+    Run(results, options, "GamepadController/MakeHidReport", [&]
+        {
+            auto report = fixture.Controller.MakeHidReport();
+            DoNotOptimize(report);
+        });
+
+    uint8_t mpuBuffer[64];
+    Run(results, options, "GamepadController/MakeMpuBuffer", [&]
+        {
+            DoNotOptimize(fixture.Controller.MakeMpuBuffer({mpuBuffer, sizeof(mpuBuffer)}));
+            DoNotOptimize(mpuBuffer);
+        });
+
+    // Unchanged samples encode to the shortest deltas, with a keyframe every MpuKeyframeInterval reports
+    TinyCon::MpuEncoder encoder;
+    uint8_t encoded[TinyCon::MpuEncoder::MaxSize];
+    fixture.Controller.SetMpuFormat(Tiny::Drivers::Input::TITinyConMpuFormats::Delta);
+    Run(results, options, "MpuEncoder/Delta", [&]
+        {
+            DoNotOptimize(encoder.Encode(fixture.Controller, {encoded, sizeof(encoded)}));
+            encoder.Sent();
+            DoNotOptimize(encoded);
+        });
+    fixture.Controller.SetMpuFormat(Tiny::Drivers::Input::TITinyConMpuFormats::Half);
+
+    // Both filters see unchanged reports, which is the common case and has to compare every value
+    TinyCon::GamepadReportFilter gamepadFilter;
+    const auto gamepadReport = fixture.Controller.MakeHidReport();
+    gamepadFilter.Sent(gamepadReport, 0);
+    Run(results, options, "ReportFilter/Gamepad", [&] { DoNotOptimize(gamepadFilter.IsDue(gamepadReport, 1)); });
+
+    TinyCon::MpuReportFilter mpuFilter;
+    const auto mpuFields = fixture.Controller.GetMpuFields();
+    fixture.Controller.SetAccelerationEnabled(true);
+    fixture.Controller.SetAngularVelocityEnabled(true);
+    fixture.Controller.SetOrientationEnabled(true);
+    fixture.Controller.SetTemperatureEnabled(true);
+    const auto mpuSize = fixture.Controller.MakeMpuBuffer({mpuBuffer, sizeof(mpuBuffer)});
+    mpuFilter.Sent({mpuBuffer, mpuSize}, fixture.Controller.GetMpuFields(), 0);
+    Run(results, options, "ReportFilter/Mpu", [&] { DoNotOptimize(mpuFilter.IsDue({mpuBuffer, mpuSize}, fixture.Controller.GetMpuFields(), 1)); });
+    // The following benchmarks keep measuring the default data set
+    fixture.Controller.SetAccelerationEnabled(mpuFields & 8);
+    fixture.Controller.SetAngularVelocityEnabled(mpuFields & 4);
+    fixture.Controller.SetOrientationEnabled(mpuFields & 2);
+    fixture.Controller.SetTemperatureEnabled(mpuFields & 1);
+
+    Run(results, options, "GamepadController/UpdateMpus", [&] { fixture.Controller.UpdateMpus(); });
+
+    Run(results, options, "GamepadController/UpdateInputs", [&] { fixture.Controller.UpdateInputs(); });
+    // One report worth of samples for every input, then the decimation and the snapshot
+    Run(results, options, "GamepadController/DecimateInputs", [&]
+        {
+            fixture.Controller.UpdateInputs();
+            fixture.Controller.DecimateInputs();
+            DoNotOptimize(fixture.Controller.GetSnapshot());
+        });
+
+    Run(results, options, "CommandProcessor/Update", [&]
+        {
+            fixture.Processor.Update();
+            DoNotOptimize(fixture.Processor.Registers);
+        });
+
+    const uint8_t command[TinyCon::CommandProcessor::MaxCommandSize] = {static_cast<uint8_t>(Tiny::Drivers::Input::TITinyConCommands::MPUDataEnable), 0x0F};
+    Run(results, options, "CommandProcessor/ProcessCommand", [&] { DoNotOptimize(fixture.Processor.ProcessCommand({command, sizeof(command)})); });
+
+    // All 32 buttons bouncing at once, in both modes
+    uint32_t pattern = 0x0F3C5A96;
+    for (const auto eager : {false, true})
+    {
+        TinyCon::ButtonDebouncer buttons;
+        buttons.Configure(TinyCon::ButtonDebounceDepth, eager);
+        Run(results, options, eager ? "ButtonDebouncer/UpdateEager" : "ButtonDebouncer/Update", [&]
+            {
+                pattern = pattern * 1664525 + 1013904223;
+                DoNotOptimize(buttons.Update(pattern));
+            });
+    }
+
+    // A stick pair through the whole pipeline, with every stage enabled
+    TinyCon::AxisProcessor axisX, axisY;
+    axisX.Configure({TinyCon::AxisConfig::Calibrate | TinyCon::AxisConfig::Radial, 16, 8, 128, 64});
+    axisY.Configure({TinyCon::AxisConfig::Calibrate, 16, 8, 128, 64});
+    int16_t axisRaw = 0;
+    Run(results, options, "AxisProcessor/Stick", [&]
+        {
+            axisRaw = static_cast<int16_t>(axisRaw * 75 + 74);
+            auto x = axisX.Calibrate(axisRaw);
+            auto y = axisY.Calibrate(static_cast<int16_t>(~axisRaw));
+            TinyCon::AxisProcessor::ApplyRadialDeadzone(axisX, x, y);
+            DoNotOptimize(axisX.Shape(x, false));
+            DoNotOptimize(axisY.Shape(y, false));
+        });
+
+    // One sample of a slowly turning sensor, with the magnetometer, as each FIFO sample goes through it
+    TinyCon::OrientationFilter fusion;
+    fusion.Configure(TinyCon::MpuFusionProportionalGain, 0.01f, TinyCon::MpuController::SamplePeriod * 1e-6f);
+    float turn = 0;
+    Run(results, options, "OrientationFilter/Update", [&]
+        {
+            turn += 0.001f;
+            fusion.Update({0.12f + turn, -0.34f, 9.81f}, {0.01f, -0.02f, 0.3f}, {21.5f, 4.25f - turn, -40.0f});
+            DoNotOptimize(fusion.GetOrientation());
+            if (turn > 1) turn = 0;
+        });
+
+    // One sample of a still sensor, a window is learned every MpuStillTime
+    TinyCon::GyroBias bias;
+    bias.Configure(TinyCon::MpuController::SamplePeriod);
+    float noise = 0;
+    Run(results, options, "GyroBias/Update", [&]
+        {
+            noise = -noise + 0.001f;
+            bias.Update({0.01f + noise, -0.02f, 0.003f - noise}, {0.12f, -0.34f + noise, 9.81f}, 31.5f);
+            DoNotOptimize(bias.Get(31.5f));
+        });
+
+    TinyCon::HapticController haptic;
+    haptic.Init(fixture.Queue, fixture.Discovery);
+    const uint8_t waveform[8] = {1, 2, 3, 4, 5, 6, 7, 8};
+    Run(results, options, "HapticController/Queue", [&]
+        {
+            for (uint8_t i = 0; i < 4; ++i) haptic.Insert(static_cast<uint8_t>(Tiny::Drivers::Input::TITinyConHapticCommands::PlayWaveform), 8, waveform, 100);
+            DoNotOptimize(haptic.GetHapticQueueSize());
+            haptic.RemoveHapticCommand(1);
+            haptic.ClearHapticCommands();
+        });
+
+    uint8_t rx[6];
+    Run(results, options, "I2CQueue/WriteRead", [&]
+        {
+            fixture.Queue.WriteRead(0x5A, {0x01}, rx, sizeof(rx));
+            fixture.Queue.Flush();
+            DoNotOptimize(rx);
+        });
+
+    // One Devices tick of background discovery, the probes included
+    Run(results, options, "DiscoveryService/Update", [&]
+        {
+            fixture.Discovery.Update();
+            fixture.Queue.Flush();
+        });
+
+    std::printf("{\n  \"benchmarks\": [\n");
+    for (std::size_t i = 0; i < results.size(); ++i)
+    {
+        const auto& result = results[i];
+        std::printf("    {\"name\": \"%s\", \"iterations\": %llu, \"ns_per_op\": %.2f, \"allocs_per_op\": %.3f}%s\n",
+                    result.Name, static_cast<unsigned long long>(result.Iterations), result.NsPerOp, result.AllocsPerOp,
+                    i + 1 < results.size() ? "," : "");
+    }
+    std::printf("  ]\n}\n");
+    return 0;
+}
@@ -0,0 +1,123 @@
+#pragma once
+
+#include <Arduino.h>
+
+#include <array>
+#include <cstdint>
+#include <cstring>
+
+namespace TinyCon::Host
+{
+    /**
+     * Host-side stand-in for an I2C master bus, used by the host builds of the I2CQueue. Devices are simple register
+     * files, the first written byte sets the register pointer, following writes and reads auto-increment it. Each
+     * transaction takes as long as clocking its bytes out at the configured clock would take, so ordering and
+     * throughput of the queue can be checked without hardware. Finished transactions are kept in a small trace.
+     * Optionally a TCA9548A style mux sits on the bus, its control byte selects which channels' devices answer
+     * next to the ones on the root bus.
+     */
+    class MockI2CBus
+    {
+    public:
+        struct Device
+        {
+            bool Present = false;
+            uint8_t Pointer = 0;
+            std::array<uint8_t, 256> Registers{};
+        };
+
+        struct TraceEntry
+        {
+            uint8_t Address;
+            uint8_t TxSize;
+            uint8_t RxSize;
+            uint8_t Register;
+            bool Success;
+        };
+
+        static constexpr int MaxTraceEntries = 64;
+        static constexpr int8_t MaxChannels = 8;
+
+        void SetClock(uint32_t clock) { Clock = clock; }
+        /** Transactions finish right away whatever the clock, e.g. to measure only the code driving the bus */
+        void SetInstant(bool instant) { Instant = instant; }
+        /** Puts a mux at the given address, devices added to a channel only answer while it is selected */
+        void SetMux(uint8_t address) { MuxAddress = address & 0x7F; }
+        /** The device at the address on the given mux channel, or on the root bus for a negative channel */
+        Device& GetDevice(uint8_t address, int8_t channel = -1) { return Devices[channel + 1][address & 0x7F]; }
+        void AddDevice(uint8_t address, int8_t channel = -1) { GetDevice(address, channel).Present = true; }
+        [[nodiscard]] uint8_t GetMuxChannels() const { return MuxChannels; }
+
+        /** The device answering the address right now, root devices win over channel devices */
+        Device& Resolve(uint8_t address)
+        {
+            auto& root = GetDevice(address);
+            if (root.Present || MuxAddress > 0x7F) return root;
+            for (int8_t channel = 0; channel < MaxChannels; ++channel)
+                if ((MuxChannels >> channel) & 1 && GetDevice(address, channel).Present) return GetDevice(address, channel);
+            return root;
+        }
+
+        void Start(uint8_t address, const uint8_t* tx, uint8_t txSize, uint8_t* rx, uint8_t rxSize)
+        {
+            if ((address & 0x7F) == MuxAddress)
+            {
+                // The mux has a single control register, no register pointer
+                if (txSize) MuxChannels = tx[txSize - 1];
+                for (uint8_t i = 0; i < rxSize; ++i) rx[i] = MuxChannels;
+                Finish(address, txSize, rxSize, MuxChannels, true);
+                return;
+            }
+
+            auto& device = Resolve(address);
+            Success = device.Present;
+            uint8_t reg = device.Pointer;
+            if (Success)
+            {
+                if (txSize) reg = device.Pointer = tx[0];
+                for (uint8_t i = 1; i < txSize; ++i) device.Registers[device.Pointer++] = tx[i];
+                for (uint8_t i = 0; i < rxSize; ++i) rx[i] = device.Registers[device.Pointer++];
+            }
+            Finish(address, txSize, rxSize, reg, Success);
+        }
+
+        bool Poll(bool& success)
+        {
+            if (Running && micros() - StartTime < Duration) return false;
+            Running = false;
+            success = Success;
+            return true;
+        }
+
+        void Stop() { Running = false; }
+
+        [[nodiscard]] uint32_t GetTraceCount() const { return TraceCount; }
+        [[nodiscard]] const TraceEntry& GetTrace(uint32_t index) const { return Trace[index % MaxTraceEntries]; }
+        void ClearTrace() { TraceCount = 0; }
+
+    private:
+        void Finish(uint8_t address, uint8_t txSize, uint8_t rxSize, uint8_t reg, bool success)
+        {
+            Success = success;
+            // 9 clocks per byte including the ACK, the address byte for each phase, plus start and stop conditions
+            const uint32_t bytes = (txSize ? txSize + 1 : 0) + (rxSize ? rxSize + 1 : 0);
+            Duration = Instant ? 0 : (bytes * 9 + 2) * 1000000ull / Clock;
+            StartTime = micros();
+            Running = true;
+
+            Trace[TraceCount++ % MaxTraceEntries] = {address, txSize, rxSize, reg, Success};
+        }
+
+        std::array<std::array<Device, 128>, MaxChannels + 1> Devices{};
+        std::array<TraceEntry, MaxTraceEntries> Trace{};
+        uint32_t TraceCount = 0;
+        uint32_t Clock = 400000;
+        uint32_t StartTime = 0;
+        uint32_t Duration = 0;
+        bool Running = false;
+        bool Instant = false;
+        bool Success = false;
+        uint8_t MuxAddress = 0xFF;
+        uint8_t MuxChannels = 0;
+    };
+}
@@ -6,7 +6,12 @@ using LogI2C = Tiny::TILogTarget<TinyCon::I2CLogLevel>;
 
 std::function<void(int)> TinyCon::I2CController::I2CReceiveCallback = [](int) {};
 std::function<void()> TinyCon::I2CController::I2CRequestCallback = []() {};
-void TinyCon::I2CController::I2CSlaveReceive(int count) { I2CReceiveCallback(count); }
+void TinyCon::I2CController::I2CSlaveReceive(int count)
+{
+    // A command may enable USB or Bluetooth again, let the state machine see it without waiting for the next wake
+    WakeController::Signal(WakeController::WakeI2C);
+    I2CReceiveCallback(count);
+}
 void TinyCon::I2CController::I2CSlaveRequest() { I2CRequestCallback(); }
 
 void TinyCon::I2CController::Init()
@@ -35,10 +40,33 @@ void TinyCon::I2CController::Send()
         LogI2C::Debug("IR:");
         if (RegisterAddress < 0x10) LogI2C::Debug("0");
         LogI2C::Debug(RegisterAddress, Tiny::TIFormat::Hex, Tiny::TIEndl);
-        SlaveI2C.write(Processor.Registers.data() + RegisterAddress, TinyCon::MaxI2CWriteBufferFill);
+        const auto size = Tiny::Math::Min(TinyCon::MaxI2CWriteBufferFill, static_cast<int>(Processor.Registers.size() - RegisterAddress));
+        SlaveI2C.write(Processor.Registers.data() + RegisterAddress, size);
+
+        // Only reads covering the controller data count towards the latency, the profiler is the loop's, so the read is
+        // only noted here and added in Update. Until then further reads are dropped, only the first one counts anyway.
+        if (!ReadPending && RegisterAddress < CommandProcessor::DataEnd && RegisterAddress + size > CommandProcessor::DataStart)
+        {
+            ReadInputTimestamp = Processor.GetInputTimestamp();
+            ReadTime = micros();
+            ReadPending = true;
+        }
     }
 }
 
+void TinyCon::I2CController::Update()
+{
+    if (!ReadPending) return;
+
+    const uint32_t timestamp = ReadInputTimestamp;
+    const uint32_t time = ReadTime;
+    ReadPending = false;
+    // Reads are served whether anything changed or not, only the first one carrying a sample counts
+    if (timestamp == LastInputTimestamp) return;
+    LastInputTimestamp = timestamp;
+    Profile.AddMicros(Profiler::Stages::I2CInputLatency, time - timestamp);
+}
+
 void TinyCon::I2CController::Receive()
 {
     if (Processor.GetI2CEnabled())
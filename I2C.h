@@ -3,7 +3,9 @@
 #include "Config.h"
 
 #include "CommandProcessor.h"
+#include "Profiler.h"
 #include "Utilities.h"
+#include "Wake.h"
 
 #include <Arduino.h>
 #include <Wire.h>
@@ -14,11 +16,13 @@ namespace TinyCon
     class I2CController
     {
     public:
-        I2CController(TwoWire& slaveI2C, CommandProcessor& processor) : SlaveI2C(slaveI2C), Processor(processor) {}
+        I2CController(TwoWire& slaveI2C, CommandProcessor& processor, Profiler& profile) : SlaveI2C(slaveI2C), Processor(processor), Profile(profile) {}
 
         void Init();
         void Send();
         void Receive();
+        /** Adds the latency of the last data read by the master to the profile */
+        void Update();
 
     private:
         static void I2CSlaveReceive(int count);
@@ -28,7 +32,13 @@ namespace TinyCon
 
         TwoWire& SlaveI2C;
         CommandProcessor& Processor;
+        Profiler& Profile;
 
         uint8_t RegisterAddress = 0;
+        uint32_t LastInputTimestamp = 0;
+        // Written by Send in the request ISR, taken by Update
+        volatile bool ReadPending = false;
+        volatile uint32_t ReadInputTimestamp = 0;
+        volatile uint32_t ReadTime = 0;
     };
 }
\ No newline at end of file
@@ -0,0 +1,311 @@
+#include "I2CQueue.h"
+
+#include <cstring>
+
+using LogI2C = Tiny::TILogTarget<TinyCon::I2CLogLevel>;
+
+bool TinyCon::I2CQueue::Submit(I2CAddress address, const uint8_t* tx, uint8_t txSize, uint8_t* rx, uint8_t rxSize, I2CTransaction::Callback complete, void* context)
+{
+    if (txSize > I2CTransaction::MaxTxSize || (txSize == 0 && rxSize == 0) || GetI2CChannel(address) >= I2CMuxChannelCount)
+    {
+        LogI2C::Error("I2C: Invalid transaction for 0x", address, Tiny::TIFormat::Hex, Tiny::TIEndl);
+        return false;
+    }
+
+    SwitchChannel(address);
+    Enqueue(address, tx, txSize, rx, rxSize, complete, context);
+    Update();
+    return true;
+}
+
+void TinyCon::I2CQueue::Enqueue(I2CAddress address, const uint8_t* tx, uint8_t txSize, uint8_t* rx, uint8_t rxSize, I2CTransaction::Callback complete, void* context)
+{
+    // Back-pressure instead of dropping, a full queue means the bus is the bottleneck anyway
+    while (((Head + 1) & (MaxTransactions - 1)) == Tail) Update();
+
+    auto& transaction = Transactions[Head];
+    transaction.Address = address;
+    if (txSize) std::memcpy(transaction.Tx, tx, txSize);
+    transaction.TxSize = txSize;
+    transaction.Rx = rx;
+    transaction.RxSize = rxSize;
+    transaction.Complete = complete;
+    transaction.Context = context;
+    transaction.Success = false;
+    transaction.Attempts = 0;
+    Head = (Head + 1) & (MaxTransactions - 1);
+}
+
+void TinyCon::I2CQueue::SwitchChannel(I2CAddress address)
+{
+    // Devices on the bus itself answer on any channel, leaving the mux alone saves a switch back
+    const auto channel = GetI2CChannel(address);
+    if (channel == NoI2CChannel || channel == QueuedChannel) return;
+
+    const uint8_t select = 1 << channel;
+    Enqueue(I2CMuxAddress, &select, 1, nullptr, 0, &OnChannelSwitched, this);
+    QueuedChannel = channel;
+    ++ChannelSwitches;
+}
+
+void TinyCon::I2CQueue::DeselectChannels()
+{
+    if (I2CMuxChannelCount == 0 || QueuedChannel == NoI2CChannel) return;
+
+    const uint8_t select = 0;
+    Enqueue(I2CMuxAddress, &select, 1, nullptr, 0, &OnChannelSwitched, this);
+    QueuedChannel = NoI2CChannel;
+    ++ChannelSwitches;
+}
+
+void TinyCon::I2CQueue::OnChannelSwitched(void* context, const I2CTransaction& transaction)
+{
+    // The devices queued behind it will fail on their own, the next one to come along tries the switch again
+    auto& queue = *static_cast<I2CQueue*>(context);
+    if (!transaction.Success) queue.QueuedChannel = UnknownChannel;
+}
+
+void TinyCon::I2CQueue::Select(I2CAddress address)
+{
+    SwitchChannel(address);
+    Flush();
+    Apply(Profiles.Get(address));
+}
+
+void TinyCon::I2CQueue::Update()
+{
+    if (Running)
+    {
+        auto& transaction = Transactions[Tail];
+        if (!Poll(transaction))
+        {
+            if (micros() - StartTime < Timeout) return;
+            Stop(transaction);
+            LogI2C::Warning("I2C: Timeout for 0x", transaction.Address, Tiny::TIFormat::Hex, Tiny::TIEndl);
+        }
+
+        Running = false;
+        BusyTime += micros() - StartTime;
+        if (!transaction.Success && transaction.Attempts < Retries)
+        {
+            // Same slot, so it keeps its place in front of everything queued after it
+            ++transaction.Attempts;
+            Running = true;
+            StartTime = micros();
+            Start(transaction);
+            return;
+        }
+
+        if (transaction.Success)
+        {
+            ++Completed;
+            Bytes += transaction.TxSize + transaction.RxSize;
+        }
+        else ++Failed;
+
+        // Copy before releasing the slot, the callback is free to queue the next transaction
+        const auto finished = transaction;
+        Tail = (Tail + 1) & (MaxTransactions - 1);
+        if (finished.Complete) finished.Complete(finished.Context, finished);
+    }
+
+    if (!Running && Head != Tail)
+    {
+        Apply(CalibrationClock ? BusProfile{CalibrationClock, TransactionTimeout, 0} : Profiles.Get(Transactions[Tail].Address));
+        Running = true;
+        StartTime = micros();
+        Start(Transactions[Tail]);
+    }
+}
+
+void TinyCon::I2CQueue::Apply(const BusProfile& profile)
+{
+    // Changing the clock disables the peripheral for a moment, only do it when the device needs a different one
+    if (profile.Clock != CurrentClock)
+    {
+        Wire.setClock(profile.Clock);
+        CurrentClock = profile.Clock;
+    }
+    Timeout = profile.Timeout;
+    Retries = profile.Retries;
+}
+
+bool TinyCon::I2CQueue::Calibrate(const BusCalibration& calibration)
+{
+    constexpr auto clockCount = sizeof(CalibrationClocks) / sizeof(CalibrationClocks[0]);
+    Flush();
+
+    // The slowest clock is the reference, without retries so a flaky read shows up as a mismatch
+    uint8_t reference[BusCalibration::MaxSize] = {};
+    CalibrationClock = CalibrationClocks[clockCount - 1];
+    if (!CalibrationRead(calibration, reference))
+    {
+        CalibrationClock = 0;
+        return false;
+    }
+
+    auto profile = Profiles.Get(calibration.Address);
+    profile.Clock = CalibrationClock;
+    for (std::size_t i = 0; i < clockCount - 1; ++i)
+    {
+        CalibrationClock = CalibrationClocks[i];
+        auto matches = true;
+        for (int8_t read = 0; read < CalibrationReads && matches; ++read)
+        {
+            uint8_t value[BusCalibration::MaxSize] = {};
+            matches = CalibrationRead(calibration, value) && std::memcmp(value, reference, calibration.RxSize) == 0;
+        }
+
+        if (matches)
+        {
+            profile.Clock = CalibrationClock;
+            break;
+        }
+    }
+
+    CalibrationClock = 0;
+    profile.Calibrated = true;
+    Profiles.Set(calibration.Address, profile);
+    LogI2C::Info("I2C: 0x", calibration.Address, Tiny::TIFormat::Hex, " calibrated to ", profile.Clock, "Hz", Tiny::TIEndl);
+    return true;
+}
+
+bool TinyCon::I2CQueue::CalibrationRead(const BusCalibration& calibration, uint8_t* rx)
+{
+    auto success = false;
+    if (calibration.Delay)
+    {
+        Submit(calibration.Address, calibration.Tx, calibration.TxSize, nullptr, 0, nullptr, nullptr);
+        Flush();
+        delayMicroseconds(calibration.Delay);
+        Submit(calibration.Address, nullptr, 0, rx, calibration.RxSize, OnCalibrationRead, &success);
+    }
+    else Submit(calibration.Address, calibration.Tx, calibration.TxSize, rx, calibration.RxSize, OnCalibrationRead, &success);
+    Flush();
+    return success;
+}
+
+void TinyCon::I2CQueue::OnCalibrationRead(void* context, const I2CTransaction& transaction)
+{
+    *static_cast<bool*>(context) = transaction.Success;
+}
+
+void TinyCon::I2CQueue::Flush()
+{
+    while (Running || Head != Tail) Update();
+}
+
+bool TinyCon::I2CQueue::Probe(I2CAddress address)
+{
+    SwitchChannel(address);
+    Flush();
+    Wire.beginTransmission(GetI2CBusAddress(address));
+    return Wire.endTransmission() == 0;
+}
+
+#if defined(NRF52840_XXAA) || defined(NRF52832_XXAA)
+void TinyCon::I2CQueue::Start(I2CTransaction& transaction)
+{
+    Error = false;
+    Twim->EVENTS_STOPPED = 0;
+    Twim->EVENTS_ERROR = 0;
+    Twim->ERRORSRC = Twim->ERRORSRC;
+    Twim->ADDRESS = GetI2CBusAddress(transaction.Address);
+    Twim->TXD.PTR = reinterpret_cast<uint32_t>(transaction.Tx);
+    Twim->TXD.MAXCNT = transaction.TxSize;
+    Twim->RXD.PTR = reinterpret_cast<uint32_t>(transaction.Rx);
+    Twim->RXD.MAXCNT = transaction.RxSize;
+
+    if (transaction.TxSize && transaction.RxSize)
+    {
+        // Repeated start between the phases, the hardware chains them without us having to step in
+        Twim->SHORTS = TWIM_SHORTS_LASTTX_STARTRX_Msk | TWIM_SHORTS_LASTRX_STOP_Msk;
+        Twim->TASKS_STARTTX = 1;
+    }
+    else if (transaction.TxSize)
+    {
+        Twim->SHORTS = TWIM_SHORTS_LASTTX_STOP_Msk;
+        Twim->TASKS_STARTTX = 1;
+    }
+    else
+    {
+        Twim->SHORTS = TWIM_SHORTS_LASTRX_STOP_Msk;
+        Twim->TASKS_STARTRX = 1;
+    }
+}
+
+bool TinyCon::I2CQueue::Poll(I2CTransaction& transaction)
+{
+    if (Twim->EVENTS_ERROR)
+    {
+        // A NACK doesn't stop the bus on its own
+        Twim->EVENTS_ERROR = 0;
+        Twim->TASKS_STOP = 1;
+        Error = true;
+    }
+
+    if (!Twim->EVENTS_STOPPED) return false;
+
+    transaction.Success = !Error && Twim->TXD.AMOUNT == transaction.TxSize && Twim->RXD.AMOUNT == transaction.RxSize;
+    Stop(transaction);
+    return true;
+}
+
+void TinyCon::I2CQueue::Stop(I2CTransaction&)
+{
+    if (!Twim->EVENTS_STOPPED)
+    {
+        Twim->TASKS_STOP = 1;
+        for (auto start = micros(); !Twim->EVENTS_STOPPED && micros() - start < TransactionTimeout;);
+    }
+
+    // Wire polls these events itself and expects them to be cleared when it starts a transfer
+    Twim->SHORTS = 0;
+    Twim->EVENTS_STOPPED = 0;
+    Twim->EVENTS_ERROR = 0;
+    Twim->EVENTS_TXSTARTED = 0;
+    Twim->EVENTS_RXSTARTED = 0;
+    Twim->EVENTS_LASTTX = 0;
+    Twim->EVENTS_LASTRX = 0;
+    Twim->EVENTS_SUSPENDED = 0;
+    Twim->ERRORSRC = Twim->ERRORSRC;
+}
+#elif defined(HI_HOST_BUILD)
+void TinyCon::I2CQueue::Start(I2CTransaction& transaction)
+{
+    Bus.Start(GetI2CBusAddress(transaction.Address), transaction.Tx, transaction.TxSize, transaction.Rx, transaction.RxSize);
+}
+
+bool TinyCon::I2CQueue::Poll(I2CTransaction& transaction)
+{
+    bool success = false;
+    if (!Bus.Poll(success)) return false;
+    transaction.Success = success;
+    return true;
+}
+
+void TinyCon::I2CQueue::Stop(I2CTransaction&) { Bus.Stop(); }
+#else
+void TinyCon::I2CQueue::Start(I2CTransaction& transaction)
+{
+    // No DMA to hand this off to, run it right away and report completion on the next poll
+    auto success = true;
+    if (transaction.TxSize)
+    {
+        Wire.beginTransmission(GetI2CBusAddress(transaction.Address));
+        Wire.write(transaction.Tx, transaction.TxSize);
+        success = Wire.endTransmission(transaction.RxSize == 0) == 0;
+    }
+
+    if (success && transaction.RxSize)
+    {
+        success = Wire.requestFrom(GetI2CBusAddress(transaction.Address), transaction.RxSize) == transaction.RxSize;
+        for (uint8_t i = 0; i < transaction.RxSize && Wire.available(); ++i) transaction.Rx[i] = Wire.read();
+    }
+
+    transaction.Success = success;
+}
+
+bool TinyCon::I2CQueue::Poll(I2CTransaction&) { return true; }
+void TinyCon::I2CQueue::Stop(I2CTransaction&) {}
+#endif
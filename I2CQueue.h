@@ -0,0 +1,168 @@
+#pragma once
+
+#include "Config.h"
+
+#include "BusProfiles.h"
+
+#include <Arduino.h>
+#include <Wire.h>
+
+#include <array>
+#include <cstdint>
+#include <initializer_list>
+
+#if defined(NRF52840_XXAA) || defined(NRF52832_XXAA)
+#include <nordic/nrfx/mdk/nrf.h>
+#elif defined(HI_HOST_BUILD)
+#include "Host/MockI2CBus.h"
+#endif
+
+namespace TinyCon
+{
+    struct I2CTransaction
+    {
+        /** Called from I2CQueue::Update on the main loop, never from an interrupt */
+        using Callback = void (*)(void* context, const I2CTransaction& transaction);
+        static constexpr uint8_t MaxTxSize = 16;
+
+        I2CAddress Address = 0;
+        // The write data is copied into the transaction, EasyDMA can only read from RAM and callers
+        // shouldn't need to keep their buffers alive until the transaction went out.
+        uint8_t Tx[MaxTxSize] = {};
+        uint8_t TxSize = 0;
+        uint8_t* Rx = nullptr;
+        uint8_t RxSize = 0;
+        Callback Complete = nullptr;
+        void* Context = nullptr;
+        bool Success = false;
+        uint8_t Attempts = 0;
+    };
+
+    /**
+     * Queued, non-blocking I2C master transactions. Writes, reads and combined write-then-read transactions are
+     * queued with an optional completion callback and executed one after another while the main loop keeps working.
+     * On the nRF52, transactions run on the TWIM EasyDMA of the bus Wire is using, with the write and read phases
+     * chained by hardware shorts. The TWIM interrupt handler is already owned by the Wire library, so completion is
+     * polled in Update instead, which also keeps all callbacks on the main loop. Other MCUs fall back to executing the
+     * queued transactions through Wire one per Update, host builds run them against the mock bus of Wire with simulated
+     * timing, which the blocking Wire users share, mux included.
+     *
+     * Because the bus is shared with blocking Wire users (the Adafruit drivers), Flush has to be called before any of
+     * them touch the bus, so a transaction in flight is never interrupted. Select does that and also applies the bus
+     * profile of the device they are about to talk to.
+     *
+     * Each transaction runs with the clock, timeout and retries of its device's profile, the clock is only changed
+     * when the next transaction needs a different one. Devices behind the I2C mux get a channel switch queued in front
+     * of them the same way, only when the channel the mux will have by then is a different one, so callers that group
+     * their transactions by channel pay for one switch per group.
+     */
+    class I2CQueue
+    {
+    public:
+        static constexpr int8_t MaxTransactions = 16;
+        static constexpr uint32_t TransactionTimeout = 10000;
+
+        explicit I2CQueue(TwoWire& wire) : Wire(wire) {}
+
+        bool Write(I2CAddress address, std::initializer_list<uint8_t> data, I2CTransaction::Callback complete = nullptr, void* context = nullptr)
+        { return Submit(address, data.begin(), data.size(), nullptr, 0, complete, context); }
+        bool Write(I2CAddress address, const uint8_t* data, uint8_t size, I2CTransaction::Callback complete = nullptr, void* context = nullptr)
+        { return Submit(address, data, size, nullptr, 0, complete, context); }
+        bool Read(I2CAddress address, uint8_t* data, uint8_t size, I2CTransaction::Callback complete = nullptr, void* context = nullptr)
+        { return Submit(address, nullptr, 0, data, size, complete, context); }
+        /** Write the register address, then read without releasing the bus in between */
+        bool WriteRead(I2CAddress address, std::initializer_list<uint8_t> tx, uint8_t* rx, uint8_t rxSize, I2CTransaction::Callback complete = nullptr, void* context = nullptr)
+        { return Submit(address, tx.begin(), tx.size(), rx, rxSize, complete, context); }
+
+        /** Completes finished transactions and starts the next one, call as often as possible */
+        void Update();
+        /** Blocks until all queued transactions completed */
+        void Flush();
+        /** Blocking check for a device acknowledging its address */
+        bool Probe(I2CAddress address);
+        /** Flushes the queue, switches the mux to the device and applies its profile, before blocking Wire users talk to it */
+        void Select(I2CAddress address);
+        /** Queues turning all mux channels off, so that only devices on the bus itself answer the transactions after it */
+        void DeselectChannels();
+        /** Flushes the queue and applies the default profile, for devices that are not known yet */
+        void SelectDefault() { Flush(); Apply(BusProfiles::Default); }
+        /** For libraries that set the clock on their own, the next transaction sets it again */
+        void InvalidateClock() { CurrentClock = 0; }
+        /**
+         * Blocking, finds the fastest clock at which the device reads back the calibration register the same as at the
+         * slowest clock and stores it in its profile. Returns false if the device doesn't answer at all.
+         */
+        bool Calibrate(const BusCalibration& calibration);
+
+        [[nodiscard]] BusProfiles& GetProfiles() { return Profiles; }
+        [[nodiscard]] const BusProfiles& GetProfiles() const { return Profiles; }
+
+        [[nodiscard]] bool IsIdle() const { return Head == Tail; }
+        [[nodiscard]] int8_t GetPendingCount() const { return (Head + MaxTransactions - Tail) & (MaxTransactions - 1); }
+
+        [[nodiscard]] uint32_t GetCompletedCount() const { return Completed; }
+        [[nodiscard]] uint32_t GetFailedCount() const { return Failed; }
+        [[nodiscard]] uint32_t GetByteCount() const { return Bytes; }
+        [[nodiscard]] uint32_t GetBusyTime() const { return BusyTime; }
+        [[nodiscard]] uint32_t GetChannelSwitchCount() const { return ChannelSwitches; }
+
+    #if defined(HI_HOST_BUILD)
+        [[nodiscard]] Host::MockI2CBus& GetMockBus() { return Bus; }
+    #endif
+
+    private:
+    #if defined(NRF52840_XXAA) || defined(NRF52832_XXAA)
+        // The TWIM only knows these, Wire rounds everything else down to one of them
+        static constexpr uint32_t CalibrationClocks[] = {400000, 250000, 100000};
+    #else
+        static constexpr uint32_t CalibrationClocks[] = {1000000, 800000, 400000, 250000, 100000};
+    #endif
+        // Every candidate clock has to read back correctly this many times in a row
+        static constexpr int8_t CalibrationReads = 8;
+        // Whatever the mux was left at by a previous run or a failed switch, the next device behind it switches again
+        static constexpr int8_t UnknownChannel = -2;
+
+        TwoWire& Wire;
+        BusProfiles Profiles;
+        uint32_t CurrentClock = 0;
+        // Overrides the profiles while calibrating, 0 if not calibrating
+        uint32_t CalibrationClock = 0;
+        uint32_t Timeout = TransactionTimeout;
+        uint8_t Retries = 0;
+        std::array<I2CTransaction, MaxTransactions> Transactions{};
+        int8_t Head = 0;
+        int8_t Tail = 0;
+        bool Running = false;
+        uint32_t StartTime = 0;
+        // The channel the mux will be at once everything queued ran
+        int8_t QueuedChannel = UnknownChannel;
+
+        uint32_t Completed = 0;
+        uint32_t Failed = 0;
+        uint32_t Bytes = 0;
+        uint32_t BusyTime = 0;
+        uint32_t ChannelSwitches = 0;
+
+    #if defined(NRF52840_XXAA) || defined(NRF52832_XXAA)
+        // Wire is TWIM0 on the Adafruit nRF52 core
+        NRF_TWIM_Type* Twim = NRF_TWIM0;
+        bool Error = false;
+    #elif defined(HI_HOST_BUILD)
+        Host::MockI2CBus& Bus = Wire.GetMockBus();
+    #endif
+
+        void Apply(const BusProfile& profile);
+        bool CalibrationRead(const BusCalibration& calibration, uint8_t* rx);
+        static void OnCalibrationRead(void* context, const I2CTransaction& transaction);
+
+        bool Submit(I2CAddress address, const uint8_t* tx, uint8_t txSize, uint8_t* rx, uint8_t rxSize, I2CTransaction::Callback complete, void* context);
+        void Enqueue(I2CAddress address, const uint8_t* tx, uint8_t txSize, uint8_t* rx, uint8_t rxSize, I2CTransaction::Callback complete, void* context);
+        /** Queues the mux switch if the device is behind it and the mux won't be at its channel already */
+        void SwitchChannel(I2CAddress address);
+        static void OnChannelSwitched(void* context, const I2CTransaction& transaction);
+        void Start(I2CTransaction& transaction);
+        /** Returns true once the running transaction finished, successful or not */
+        bool Poll(I2CTransaction& transaction);
+        void Stop(I2CTransaction& transaction);
+    };
+}
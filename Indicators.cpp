@@ -6,10 +6,17 @@ void TinyCon::IndicatorController::Init()
 {
     pinMode(BlueLedPin, OUTPUT);
     pinMode(RedLedPin, OUTPUT);
+#if USE_OLED
+    BusProfile profile;
+    profile.Clock = DisplayClock;
+    profile.Calibrated = true;
+    MasterQueue.GetProfiles().Set(DisplayAddress, profile);
+    Discovery.Watch(DisplayAddress, DisplayInit);
+#endif
     LogIndicators::Debug("Indicators initialized", Tiny::TIEndl);
 }
 
-void TinyCon::IndicatorController::Update(uint32_t deltaTime, char mode)
+void TinyCon::IndicatorController::Update(uint32_t deltaTime)
 {
     UpdateBlue(deltaTime);
     UpdateRed(deltaTime);
@@ -17,22 +24,33 @@ void TinyCon::IndicatorController::Update(uint32_t deltaTime, char mode)
 #if USE_NEOPIXEL
     UpdateRgb(deltaTime);
 #endif
-
-#if USE_OLED
-    UpdateDisplay(mode);
-#endif
 }
 
 #if USE_OLED
 void TinyCon::IndicatorController::UpdateDisplay(char mode)
 {
+    // The discovery service saw the display depart
+    if (DisplayPresent && !DisplayInit.Is(DeviceStates::Present)) DisplayPresent = false;
     if (!DisplayPresent)
     {
+        // begin sends the whole init sequence, only try it once the discovery service saw the display answer
+        if (!DisplayInit.Is(DeviceStates::Probing) || !DisplayInit.Ready()) return;
         LogIndicators::Debug("Init", Tiny::TIEndl);
-        DisplayPresent = SSD1306.begin(SSD1306_SWITCHCAPVCC, 0x3C);
-        if (DisplayPresent) LogIndicators::Debug(" Success");
-        else LogIndicators::Debug(" Failed");
+        MasterQueue.Select(DisplayAddress);
+        DisplayPresent = SSD1306.begin(SSD1306_SWITCHCAPVCC, DisplayAddress);
+        if (DisplayPresent)
+        {
+            DisplayInit.Set(DeviceStates::Present);
+            LogIndicators::Debug(" Success");
+        }
+        else
+        {
+            DisplayInit.Lost();
+            LogIndicators::Debug(" Failed");
+        }
     }
+    // The library sets the display clock itself, before and after each transfer, same as the profile does
+    else MasterQueue.Select(DisplayAddress);
 
     if (DisplayPresent)
     {
@@ -61,7 +79,7 @@ void TinyCon::IndicatorController::UpdateDisplay(char mode)
         for (int8_t i = 0, axisY = 0; i < axisCount; ++i, ++axisY)
         {
             auto axis = Controller.GetAxis(i);
-            auto w = Tiny::Math::Max(abs(AxisRoot * axis), 1);
+            auto w = Tiny::Math::Max(abs(AxisRoot * axis) / 32768, 1);
             auto x = axis < 0 ? AxisRoot - w : AxisRoot;
             for (auto y = 0; y < axisHeight - 1; ++y, ++axisY)
                 SSD1306.drawFastHLine(x, axisY, w, 1);
@@ -151,6 +169,7 @@ void TinyCon::IndicatorController::Disable()
         analogWrite(RedLedPin, 0);
 
 #if USE_OLED
+        MasterQueue.Select(DisplayAddress);
         SSD1306.clearDisplay();
         SSD1306.display();
         SSD1306.dim(1);
@@ -158,6 +177,8 @@ void TinyCon::IndicatorController::Disable()
         Suspended = true;
     }
 }
+#else
+void TinyCon::IndicatorController::UpdateDisplay(char) {}
 #endif
 
 void TinyCon::IndicatorController::UpdateLed(uint32_t deltaTime, uint8_t& value, int32_t& time, LedEffects& current, LedEffects& next)
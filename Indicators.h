@@ -2,7 +2,9 @@
 
 #include "Config.h"
 
+#include "Discovery.h"
 #include "GamepadController.h"
+#include "I2CQueue.h"
 #include "Power.h"
 
 #if USE_NEOPIXEL
@@ -22,15 +24,17 @@ namespace TinyCon
     public:
         enum class LedEffects : int8_t { Off = 0, On = 1, Pulse = 2, Fade = 3, Fixed = 4 };
 
-        IndicatorController(TwoWire& masterI2c, const GamepadController& controller, const PowerController& power)
-            : Controller(controller), Power(power)
+        IndicatorController(TwoWire& masterI2c, I2CQueue& masterQueue, DiscoveryService& discovery, const GamepadController& controller, const PowerController& power)
+            : Controller(controller), Power(power), MasterQueue(masterQueue), Discovery(discovery)
     #if USE_OLED
-            , SSD1306{128, 32, &masterI2c, -1, 1000000}
+            , SSD1306{128, 32, &masterI2c, -1, DisplayClock, DisplayClock}
     #endif
             {}
 
         void Init();
-        void Update(uint32_t deltaTime, char mode);
+        void Update(uint32_t deltaTime);
+        /** The display is much slower to refresh than the LEDs, so it is updated separately at a lower rate */
+        void UpdateDisplay(char mode);
 
         void SetBlue(LedEffects effect) { NextBlueEffect = effect; }
         void SetRed(LedEffects effect) { NextRedEffect = effect; }
@@ -47,6 +51,8 @@ namespace TinyCon
         uint32_t LastUpdate = millis();
         const GamepadController& Controller;
         const PowerController& Power;
+        I2CQueue& MasterQueue;
+        DiscoveryService& Discovery;
 
         // This LED is on, when BLE is on and connected, fading when we are advertising or off otherwise
         static constexpr int8_t BlueLedPin = LED_BLUE;
@@ -87,6 +93,9 @@ namespace TinyCon
     #endif
 
     #if USE_OLED
+        // The SSD1306 can only be written, so its clock can't be calibrated, this is the fastest the TWIM supports
+        static constexpr uint8_t DisplayAddress = 0x3C;
+        static constexpr uint32_t DisplayClock = 400000;
         static constexpr auto DisplayHeight = 32;
         static constexpr auto AxisRoot = 16;
         static constexpr auto MpuWidth = 36;
@@ -98,8 +107,8 @@ namespace TinyCon
         static constexpr auto OrientationScale = 60;
         Adafruit_SSD1306 SSD1306;
         bool DisplayPresent = false;
+        DeviceInit DisplayInit;
         bool Suspended = false;
-        void UpdateDisplay(char mode);
     #endif
     };
 }
\ No newline at end of file
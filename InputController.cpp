@@ -1,64 +1,319 @@
 #include "InputController.h"
 
-bool TinyCon::DebouncedButton::Get() const
+void TinyCon::ButtonDebouncer::Configure(uint8_t depth, bool eager)
 {
-    int8_t count = 0;
-    for (int8_t i = 0; i < 4; ++i)
-        if (StateAt(i) && ++count > 2) return true;
+    Depth = Tiny::Math::Min(Tiny::Math::Max<uint8_t>(depth, 1), MaxDepth);
+    Eager = eager;
+    Locked = 0;
+    Counter = {};
+}
+
+uint32_t TinyCon::ButtonDebouncer::Update(uint32_t raw)
+{
+    if (Eager)
+    {
+        // A lock counts the samples after the change, it still holds on the Depth-th one
+        const auto changed = (raw ^ State) & ~Locked;
+        const auto released = Count(Locked);
+        State ^= changed;
+        Locked = (Locked & ~released) | changed;
+    }
+    else State ^= Count(raw ^ State);
+    return State;
+}
+
+uint32_t TinyCon::ButtonDebouncer::Count(uint32_t mask)
+{
+    // Ripple carry add of one through the bit planes, a button not in the mask starts over at 0
+    auto carry = mask;
+    for (auto& plane : Counter)
+    {
+        const auto next = plane & carry;
+        plane = (plane ^ carry) & mask;
+        carry = next;
+    }
+
+    auto reached = mask;
+    for (uint8_t i = 0; i < Counter.size(); ++i) reached &= (Depth >> i) & 1 ? Counter[i] : ~Counter[i];
+    for (auto& plane : Counter) plane &= ~reached;
+    return reached;
+}
+
+volatile bool TinyCon::SeesawController::InterruptPending[MaxControllers] = {};
+volatile uint32_t TinyCon::SeesawController::InterruptTime[MaxControllers] = {};
+const std::array<void (*)(), TinyCon::SeesawController::MaxControllers> TinyCon::SeesawController::InterruptHandlers =
+    MakeInterruptHandlers(std::make_index_sequence<MaxControllers>());
+
+bool TinyCon::SeesawController::IsInterruptPending()
+{
+    for (auto pending : InterruptPending) if (pending) return true;
     return false;
 }
 
-void TinyCon::SeesawController::Init(TwoWire& i2c, int8_t controller)
+void TinyCon::SeesawController::Init(TwoWire& i2c, I2CQueue& queue, DiscoveryService& discovery, int8_t controller, int8_t interruptPin)
 {
     Device = {&i2c};
+    I2C = &i2c;
+    Queue = &queue;
     Controller = controller;
-    if ((Present = Device.begin(AddressByController[Controller]))) Init();
+    InterruptPin = interruptPin;
+    if (InterruptPin != NC)
+    {
+        pinMode(InterruptPin, INPUT_PULLUP);
+        attachInterrupt(digitalPinToInterrupt(InterruptPin), InterruptHandlers[Controller], FALLING);
+    }
+    InitState.Set(DeviceStates::Absent);
+    discovery.Watch(GetAddress(), InitState);
 }
 
-void TinyCon::SeesawController::Init()
+void TinyCon::SeesawController::UpdateInit()
+{
+    if (!InitState.Ready()) return;
+
+    const auto address = GetI2CBusAddress(GetAddress());
+    // Every step talks to the pad through the Adafruit library, which needs the pad's mux channel selected
+    if (!InitState.Is(DeviceStates::Absent)) Queue->Select(GetAddress());
+    switch (InitState.State)
+    {
+        case DeviceStates::Absent:
+            // Nothing to do until the discovery service saw the address acknowledge
+            break;
+        case DeviceStates::Probing:
+            // Device.begin retries for about 100ms on a missing device, which is why it waits for discovery
+            if (!Device.begin(address, -1, false))
+            {
+                InitState.Lost();
+                break;
+            }
+            Device.SWReset();
+            InitState.Wait(DeviceStates::Resetting, ResetTime);
+            break;
+        case DeviceStates::Resetting:
+            I2C->beginTransmission(address);
+            if (I2C->endTransmission() == 0) InitState.Set(DeviceStates::Configuring);
+            else if (InitState.Retries < ResetRetries) InitState.Retry(ResetTime);
+            else InitState.Lost();
+            break;
+        case DeviceStates::Configuring:
+            Configure();
+            InitState.Set(DeviceStates::Present);
+            Present = true;
+            break;
+        default:
+            InitState.Lost();
+            break;
+    }
+}
+
+void TinyCon::SeesawController::Configure()
 {
     Device.pinModeBulk(InputButtonMask, INPUT_PULLUP);
     Device.setGPIOInterrupts(InputButtonMask, 1);
+
+    // Start from a known state, in interrupt mode we may not see a button read until the next change
+    Buttons.Reset();
+    ReadButtons(true);
+    ReadAxis();
 }
 
 void TinyCon::SeesawController::Update()
 {
+    if (Present && !InitState.Is(DeviceStates::Present))
+    {
+        // The discovery service saw the pad depart
+        Present = false;
+        Needed = Collected = Failed = 0;
+    }
     if (!Present)
     {
-        if ((Present = Device.begin(AddressByController[Controller]))) Init();
+        UpdateInit();
+        return;
+    }
+
+    if (Failed != 0)
+    {
+        // A pad that stopped answering was unplugged or is rebooting, bring it up again from scratch
+        Present = false;
+        InitState.Lost();
+        Needed = Collected = Failed = 0;
+        return;
     }
-    else if (auto buttonStates = Device.digitalReadBulk(InputButtonMask))
+
+    if (Collected & (1 << static_cast<uint8_t>(Phases::Buttons)))
     {
-        for (auto i = 0; i < InputButtonCount; ++i)
-            Buttons[i].AddState((buttonStates & InputButtons[i]) == 0);
-        for (auto i = 0; i < InputAxisCount; ++i)
-            Axis[i] = Tiny::Math::Min(Tiny::Math::Max(Device.analogRead(InputAxis[i]) / 512.0f - 1.0f, -1.0f), 1.0f);
+        const auto& rx = Rx[static_cast<uint8_t>(Phases::Buttons)];
+        const auto states = ((static_cast<uint32_t>(rx[0]) << 24) | (rx[1] << 16) | (rx[2] << 8) | rx[3]) & InputButtonMask;
+        if (states != ButtonStates) EdgeTime = SampleTime;
+        ButtonStates = states;
+        LastButtonTime = millis();
+    }
+    for (auto i = 0; i < InputAxisCount; ++i)
+        if (Collected & (1 << (static_cast<uint8_t>(Phases::Axis0) + i)))
+        {
+            const auto& rx = Rx[static_cast<uint8_t>(Phases::Axis0) + i];
+            Axis[i] = ToQ15(static_cast<int32_t>((rx[0] << 8) | rx[1]));
+            LastAxisTime = millis();
+        }
+    Needed = Collected = 0;
+
+    if (ButtonStates != 0)
+    {
+        // Without a change, the debouncer still needs to see the held state every update
+        uint32_t pressed = 0;
+        for (auto i = 0; i < InputButtonCount; ++i) pressed |= static_cast<uint32_t>((ButtonStates & InputButtons[i]) == 0) << i;
+        Buttons.Update(pressed);
     }
     else
+    {
         // This is relevant for Seesaw inputs we connect via Stemma QT, since they may still have a reset button.
         // This will result in the input register being all 0's, looking like all buttons are pressed at the same
         // time. Try to reinitialize the device, causing a software reset in the process. Discard the input after,
         // so we don't get random results because of the cached button states.
         Present = false;
+        InitState.Lost();
+    }
+}
+
+void TinyCon::SeesawController::Prepare()
+{
+    auto need = [this](Phases phase) { Needed |= 1 << static_cast<uint8_t>(phase); };
+    Needed = Collected = Failed = 0;
+
+    const auto time = millis();
+    if (InterruptPin == NC)
+    {
+        need(Phases::Buttons);
+        need(Phases::Axis0);
+        need(Phases::Axis1);
+        SampleTime = micros();
+        return;
+    }
+
+    // The Seesaw keeps INT low until its interrupt flags are read, checking the level as well catches any edge
+    // that arrived while we were still busy reading the previous change.
+    const auto pending = InterruptPending[Controller] || digitalRead(InterruptPin) == LOW;
+    SampleTime = InterruptPending[Controller] ? InterruptTime[Controller] : micros();
+    InterruptPending[Controller] = false;
+    if (pending) need(Phases::Flags);
+    if (pending || time - LastButtonTime >= ButtonResyncInterval) need(Phases::Buttons);
+    if (time - LastAxisTime >= AxisInterval)
+    {
+        need(Phases::Axis0);
+        need(Phases::Axis1);
+    }
+}
+
+bool TinyCon::SeesawController::Request(Phases phase)
+{
+    if (!(Needed & (1 << static_cast<uint8_t>(phase)))) return false;
+
+    const auto address = GetAddress();
+    switch (phase)
+    {
+        case Phases::Flags: return Queue->Write(address, {SEESAW_GPIO_BASE, SEESAW_GPIO_INTFLAG});
+        case Phases::Buttons: return Queue->Write(address, {SEESAW_GPIO_BASE, SEESAW_GPIO_BULK});
+        case Phases::Axis0:
+        case Phases::Axis1:
+        {
+            const auto channel = InputAxisChannels[static_cast<uint8_t>(phase) - static_cast<uint8_t>(Phases::Axis0)];
+            return Queue->Write(address, {SEESAW_ADC_BASE, static_cast<uint8_t>(SEESAW_ADC_CHANNEL_OFFSET + channel)});
+        }
+        default: return false;
+    }
+}
+
+void TinyCon::SeesawController::Collect(Phases phase)
+{
+    const auto index = static_cast<uint8_t>(phase);
+    if (!(Needed & (1 << index))) return;
+    // The flags only need to be read to release INT, the button states come with the next phase
+    const uint8_t size = phase >= Phases::Axis0 ? 2 : 4;
+    Queue->Read(GetAddress(), Rx[index], size, OnCollected, this);
+}
+
+void TinyCon::SeesawController::OnCollected(void* context, const I2CTransaction& transaction)
+{
+    auto& seesaw = *static_cast<SeesawController*>(context);
+    const auto phase = static_cast<uint8_t>((transaction.Rx - seesaw.Rx[0]) / sizeof(seesaw.Rx[0]));
+    if (transaction.Success) seesaw.Collected |= 1 << phase;
+    else seesaw.Failed |= 1 << phase;
+}
+
+void TinyCon::SeesawController::ReadButtons(bool clearInterrupt)
+{
+    const auto time = InterruptPending[Controller] ? InterruptTime[Controller] : micros();
+    InterruptPending[Controller] = false;
+    if (clearInterrupt)
+    {
+        uint8_t flags[4];
+        Device.read(SEESAW_GPIO_BASE, SEESAW_GPIO_INTFLAG, flags, sizeof(flags));
+    }
+
+    const auto states = Device.digitalReadBulk(InputButtonMask);
+    if (states != ButtonStates) EdgeTime = time;
+    ButtonStates = states;
+    LastButtonTime = millis();
+}
+
+void TinyCon::SeesawController::ReadAxis()
+{
+    for (auto i = 0; i < InputAxisCount; ++i)
+        Axis[i] = ToQ15(Device.analogRead(InputAxis[i]));
+    LastAxisTime = millis();
 }
 
 bool TinyCon::SeesawController::GetUpdatedButton(int8_t index) const
 {
+    if (!Present) return false;
+    Queue->Select(GetAddress());
+    if (InterruptPin != NC)
+    {
+        // INT stays low until the flags are read, without this no further press could wake us while suspended
+        InterruptPending[Controller] = false;
+        uint8_t flags[4];
+        Device.read(SEESAW_GPIO_BASE, SEESAW_GPIO_INTFLAG, flags, sizeof(flags));
+    }
     const auto mask = InputButtons[index];
     return Device.digitalReadBulk(mask) == 0;
 }
 void TinyCon::SeesawController::Reset()
 {
     Present = false;
+    Queue->Select(GetAddress());
     Device.SWReset();
+    InitState.Wait(DeviceStates::Resetting, ResetTime);
 }
 
 void TinyCon::PinsInputController::Update()
 {
-    for (std::size_t axisIndex = 0; axisIndex < AxisPins.size(); ++axisIndex)
-        Axis[axisIndex] = analogRead(AxisPins[axisIndex]) / 512.0f - 1.0f;
-    for (std::size_t buttonIndex = 0; buttonIndex < ButtonPins.size(); ++buttonIndex)
-        Buttons[buttonIndex].AddState(digitalRead(ButtonPins[buttonIndex]) == ((ButtonActiveState == ActiveState::High) ? HIGH : LOW));
+#if defined(NRF52840_XXAA) || defined(NRF52832_XXAA)
+    // The axis of the previous scan are picked up and the next scan runs while the buttons and everything else of
+    // this frame are processed
+    if (AxisCount > 0 && CollectScan()) StartScan();
+
+#if defined(NRF52840_XXAA)
+    const uint32_t ports[] = {NRF_P0->IN, NRF_P1->IN};
+#else
+    const uint32_t ports[] = {NRF_P0->IN};
+#endif
+    uint32_t raw = 0;
+    for (int16_t buttonIndex = 0; buttonIndex < ButtonCount; ++buttonIndex)
+    {
+        const auto pin = ButtonPortPins[buttonIndex];
+        raw |= ((ports[pin >> 5] >> (pin & 31)) & 1) << buttonIndex;
+    }
+    raw ^= ButtonInvert;
+#else
+    for (int16_t axisIndex = 0; axisIndex < AxisCount; ++axisIndex)
+        Axis[axisIndex] = static_cast<int16_t>((Tiny::Math::Min(Tiny::Math::Max(analogRead(AxisPins[axisIndex]), 0), 1023) << 6) - 32768);
+    AxisValid = true;
+    uint32_t raw = 0;
+    for (int16_t buttonIndex = 0; buttonIndex < ButtonCount; ++buttonIndex)
+        raw |= static_cast<uint32_t>(digitalRead(ButtonPins[buttonIndex]) == ((ButtonActiveState == ActiveState::High) ? HIGH : LOW)) << buttonIndex;
+#endif
+    Buttons.Update(raw);
+    if (raw != RawButtons) EdgeTime = micros();
+    RawButtons = raw;
 }
 
 bool TinyCon::PinsInputController::GetUpdatedButton(int8_t index) const
@@ -74,7 +329,92 @@ void TinyCon::PinsInputController::Init(const std::array<int8_t, MaxNativeAdcPin
     ButtonActiveState = activeState;
     memcpy(AxisPins.data(), axisPins.data(), AxisPins.size() * sizeof(int8_t));
     memcpy(ButtonPins.data(), buttonPins.data(), ButtonPins.size() * sizeof(int8_t));
+    for (int16_t i = 0; i < ButtonCount; ++i) pinMode(ButtonPins[i], activeState == ActiveState::High ? INPUT_PULLDOWN : INPUT_PULLUP);
+
+#if defined(NRF52840_XXAA) || defined(NRF52832_XXAA)
+    for (int16_t i = 0; i < ButtonCount; ++i) ButtonPortPins[i] = g_ADigitalPinMap[ButtonPins[i]];
+    ButtonInvert = activeState == ActiveState::Low ? (1u << ButtonCount) - 1 : 0;
+    for (int16_t i = 0; i < AxisCount; ++i) AxisInputs[i] = GetAnalogInput(g_ADigitalPinMap[AxisPins[i]]);
+    Scanning = false;
+#endif
+    AxisValid = false;
+}
+
+#if defined(NRF52840_XXAA) || defined(NRF52832_XXAA)
+uint32_t TinyCon::PinsInputController::GetAnalogInput(uint32_t pin)
+{
+    // Same mapping as analogRead in the Arduino core, the SAADC inputs are fixed to these pins
+    switch (pin)
+    {
+        case 2: return SAADC_CH_PSELP_PSELP_AnalogInput0;
+        case 3: return SAADC_CH_PSELP_PSELP_AnalogInput1;
+        case 4: return SAADC_CH_PSELP_PSELP_AnalogInput2;
+        case 5: return SAADC_CH_PSELP_PSELP_AnalogInput3;
+        case 28: return SAADC_CH_PSELP_PSELP_AnalogInput4;
+        case 29: return SAADC_CH_PSELP_PSELP_AnalogInput5;
+        case 30: return SAADC_CH_PSELP_PSELP_AnalogInput6;
+        case 31: return SAADC_CH_PSELP_PSELP_AnalogInput7;
+        default: return SAADC_CH_PSELP_PSELP_NC;
+    }
+}
+
+void TinyCon::PinsInputController::StartScan()
+{
+    // Same gain and reference as analogRead, 0 to 3.6V, but at 12 bit and all axis in one go. With oversampling,
+    // burst mode takes all samples of a channel in one go, otherwise each sample task would only advance by one.
+    constexpr uint32_t config = (SAADC_CH_CONFIG_GAIN_Gain1_6 << SAADC_CH_CONFIG_GAIN_Pos) | (SAADC_CH_CONFIG_REFSEL_Internal << SAADC_CH_CONFIG_REFSEL_Pos)
+        | (SAADC_CH_CONFIG_TACQ_10us << SAADC_CH_CONFIG_TACQ_Pos) | (SAADC_CH_CONFIG_MODE_SE << SAADC_CH_CONFIG_MODE_Pos)
+        | ((NativeAdcOversampling ? SAADC_CH_CONFIG_BURST_Enabled : SAADC_CH_CONFIG_BURST_Disabled) << SAADC_CH_CONFIG_BURST_Pos);
+
+    auto* buffer = AxisBuffers[AxisBuffer];
+    NRF_SAADC->RESOLUTION = SAADC_RESOLUTION_VAL_12bit;
+    NRF_SAADC->OVERSAMPLE = NativeAdcOversampling;
+    NRF_SAADC->SAMPLERATE = SAADC_SAMPLERATE_MODE_Task << SAADC_SAMPLERATE_MODE_Pos;
+    // analogRead reconfigures the SAADC for itself, so the channels are set up again for every scan
+    for (int16_t i = 0; i < AxisCount; ++i)
+    {
+        NRF_SAADC->CH[i].PSELP = AxisInputs[i];
+        NRF_SAADC->CH[i].PSELN = SAADC_CH_PSELN_PSELN_NC;
+        NRF_SAADC->CH[i].CONFIG = config;
+    }
+    NRF_SAADC->RESULT.PTR = reinterpret_cast<uint32_t>(buffer);
+    NRF_SAADC->RESULT.MAXCNT = AxisCount;
+    NRF_SAADC->ENABLE = SAADC_ENABLE_ENABLE_Enabled;
+
+    NRF_SAADC->EVENTS_STARTED = 0;
+    NRF_SAADC->EVENTS_END = 0;
+    NRF_SAADC->TASKS_START = 1;
+    while (!NRF_SAADC->EVENTS_STARTED) {}
+    NRF_SAADC->EVENTS_STARTED = 0;
+    NRF_SAADC->TASKS_SAMPLE = 1;
+    Scanning = true;
+}
+
+bool TinyCon::PinsInputController::CollectScan()
+{
+    if (!Scanning) return true;
+
+    const auto* buffer = AxisBuffers[AxisBuffer];
+    // analogRead elsewhere, e.g. for the battery voltage, points the SAADC at its own buffer, the scan is lost then
+    const auto ours = NRF_SAADC->RESULT.PTR == reinterpret_cast<uint32_t>(buffer);
+    if (ours && !NRF_SAADC->EVENTS_END) return false;
+
+    Scanning = false;
+    if (ours && NRF_SAADC->RESULT.AMOUNT == static_cast<uint32_t>(AxisCount))
+    {
+        for (int16_t i = 0; i < AxisCount; ++i)
+            Axis[i] = static_cast<int16_t>((Tiny::Math::Min(Tiny::Math::Max<int16_t>(buffer[i], 0), 4095) << 4) - 32768);
+        AxisValid = true;
+    }
+
+    // Leave the SAADC the way analogRead expects to find it, which also saves its idle current
+    NRF_SAADC->EVENTS_END = 0;
+    for (int16_t i = 0; i < AxisCount; ++i) NRF_SAADC->CH[i].PSELP = SAADC_CH_PSELP_PSELP_NC;
+    NRF_SAADC->ENABLE = SAADC_ENABLE_ENABLE_Disabled;
+    AxisBuffer ^= 1;
+    return true;
 }
+#endif
 
 void TinyCon::InputController::Init(const std::array<int8_t, MaxNativeAdcPinCount>& axisPins, const std::array<int8_t, MaxNativeGpioPinCount>& buttonPins, ActiveState activeState)
 {
@@ -87,35 +427,102 @@ void TinyCon::InputController::Init(const std::array<int8_t, MaxNativeAdcPinCoun
     else Present = false;
 }
 
-void TinyCon::InputController::Init(TwoWire& i2c, int8_t controller)
+void TinyCon::InputController::Init(TwoWire& i2c, I2CQueue& queue, DiscoveryService& discovery, int8_t controller)
 {
-    if (controller < 4) Seesaw.Init(i2c, controller);
-    if (Seesaw.Present)
-    {
-        Type = Tiny::Drivers::Input::TITinyConControllerTypes::Seesaw;
-        Present = Seesaw.Present;
-    }
-    else Present = false;
+    // The Seesaw comes up on its own over the next updates, or whenever it is plugged in later
+    Present = false;
+    if (controller >= SeesawController::MaxControllers) return;
+    constexpr auto interruptPins = static_cast<int8_t>(sizeof(SeesawInterruptPins) / sizeof(SeesawInterruptPins[0]));
+    Seesaw.Init(i2c, queue, discovery, controller, controller < interruptPins ? SeesawInterruptPins[controller] : NC);
+    Type = Tiny::Drivers::Input::TITinyConControllerTypes::Seesaw;
 }
 
 void TinyCon::InputController::Update()
 {
-    int8_t axisIndex = 0;
-    int8_t buttonIndex = 0;
+    const auto present = Present;
+    const auto buttons = SampledButtons;
+    const int16_t* raw = nullptr;
     switch (Type)
     {
         case Tiny::Drivers::Input::TITinyConControllerTypes::Pins:
             Pins.Update();
-            for (float axis : Pins.Axis) Axis[axisIndex++] = axis;
-            for (auto & button : Pins.Buttons) Buttons[buttonIndex++] = button.Get();
+            // The zeros from before the first scan would otherwise be learned as the center of every axis
+            raw = Pins.AxisValid ? Pins.Axis : nullptr;
+            SampledButtons = Pins.Buttons.Get();
+            if (SampledButtons != buttons) Timestamp = Pins.EdgeTime;
             break;
         case Tiny::Drivers::Input::TITinyConControllerTypes::Seesaw:
             Seesaw.Update();
-            for (float axis : Seesaw.Axis) Axis[axisIndex++] = axis;
-            for (auto & button : Seesaw.Buttons) Buttons[buttonIndex++] = button.Get();
+            Present = Seesaw.Present;
+            raw = Seesaw.Axis;
+            SampledButtons = Seesaw.Buttons.Get();
+            if (SampledButtons != buttons) Timestamp = Seesaw.EdgeTime;
             break;
         default: break;
     }
+    if (!raw || !Present) return;
+
+    // A pad that was plugged in again may be a different one, so its center and range are learned anew
+    const auto count = GetAxisCount();
+    if (!present)
+    {
+        for (int16_t i = 0; i < count; ++i) AxisProcessors[i].ResetCalibration();
+        SampleCount = 0;
+        HeldButtons = 0;
+    }
+    Sample(raw, count);
+}
+
+void TinyCon::InputController::Sample(const int16_t* raw, int16_t count)
+{
+    HeldButtons |= SampledButtons;
+    // Should nothing decimate for this long, the window starts over before the sum could overflow
+    if (SampleCount == UINT16_MAX) SampleCount = 0;
+    for (int16_t i = 0; i < count; ++i)
+    {
+        const auto value = raw[i];
+        if (SampleCount)
+        {
+            AxisSum[i] += value;
+            AxisMin[i] = Tiny::Math::Min(AxisMin[i], value);
+            AxisMax[i] = Tiny::Math::Max(AxisMax[i], value);
+        }
+        else AxisSum[i] = AxisMin[i] = AxisMax[i] = value;
+        AxisLatest[i] = value;
+    }
+    ++SampleCount;
+}
+
+void TinyCon::InputController::Decimate()
+{
+    // Nothing new since the last report keeps what was reported, a tap is only reported once
+    Buttons = SampledButtons | HeldButtons;
+    HeldButtons = 0;
+    if (!SampleCount || !Present) return;
+
+    const auto count = GetAxisCount();
+    int16_t raw[MaxAxisCount];
+    for (int16_t i = 0; i < count; ++i)
+        switch (Decimation)
+        {
+            case InputDecimations::Average: raw[i] = static_cast<int16_t>(AxisSum[i] / SampleCount); break;
+            case InputDecimations::Peak:
+            {
+                // Further from the learned center, the first sample of a new pad becomes its center anyway
+                const auto center = static_cast<int32_t>(AxisProcessors[i].GetCenter());
+                raw[i] = AxisMax[i] - center >= center - AxisMin[i] ? AxisMax[i] : AxisMin[i];
+                break;
+            }
+            default: raw[i] = AxisLatest[i]; break;
+        }
+    SampleCount = 0;
+
+    for (int16_t i = 0; i < count; ++i) Axis[i] = AxisProcessors[i].Calibrate(raw[i]);
+    // Sticks are pairs of axis, the X axis config decides whether the pair gets a radial deadzone
+    for (int16_t i = 0; i + 1 < count; i += 2)
+        if (AxisProcessors[i].IsRadial()) AxisProcessor::ApplyRadialDeadzone(AxisProcessors[i], Axis[i], Axis[i + 1]);
+    for (int16_t i = 0; i < count; ++i)
+        Axis[i] = AxisProcessors[i].Shape(Axis[i], !AxisProcessors[i & ~1].IsRadial() || (i | 1) >= count);
 }
 
 void TinyCon::InputController::Reset()
@@ -128,6 +535,16 @@ void TinyCon::InputController::Reset()
     }
 }
 
+void TinyCon::InputController::SetDebounce(uint8_t depth, bool eager)
+{
+    switch (Type)
+    {
+        case Tiny::Drivers::Input::TITinyConControllerTypes::Pins: Pins.Buttons.Configure(depth, eager); break;
+        case Tiny::Drivers::Input::TITinyConControllerTypes::Seesaw: Seesaw.Buttons.Configure(depth, eager); break;
+        default: break;
+    }
+}
+
 bool TinyCon::InputController::GetUpdatedButton(int8_t index) const
 {
     switch (Type)
@@ -138,6 +555,22 @@ bool TinyCon::InputController::GetUpdatedButton(int8_t index) const
     }
 }
 
+bool TinyCon::InputController::CanWake() const
+{
+    return Type == Tiny::Drivers::Input::TITinyConControllerTypes::Seesaw && Seesaw.CanWake();
+}
+
+TinyCon::BusCalibration TinyCon::InputController::GetCalibration() const
+{
+    if (Type == Tiny::Drivers::Input::TITinyConControllerTypes::Seesaw && Seesaw.Present) return Seesaw.GetCalibration();
+    return {};
+}
+
+TinyCon::SeesawController* TinyCon::InputController::GetSeesaw()
+{
+    return Type == Tiny::Drivers::Input::TITinyConControllerTypes::Seesaw && Seesaw.Present ? &Seesaw : nullptr;
+}
+
 Tiny::Drivers::Input::TITinyConControllerTypes TinyCon::InputController::GetType() const
 {
     switch (Type)
@@ -163,7 +596,7 @@ int16_t TinyCon::InputController::GetButtonCount() const
     switch (Type)
     {
         case Tiny::Drivers::Input::TITinyConControllerTypes::Pins: return Pins.GetButtonCount();
-        case Tiny::Drivers::Input::TITinyConControllerTypes::Seesaw: return Seesaw.Present ? sizeof(Seesaw.Buttons) / sizeof(Seesaw.Buttons[0]): 0;
+        case Tiny::Drivers::Input::TITinyConControllerTypes::Seesaw: return Seesaw.Present ? SeesawController::GetButtonCount() : 0;
         default: return 0;
     }
 }
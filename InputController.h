@@ -1,48 +1,141 @@
 #pragma once
 
 #include "Config.h"
+#include "AxisProcessor.h"
+#include "Discovery.h"
+#include "I2CQueue.h"
 #include "Utilities.h"
+#include "Wake.h"
 
 #include "Core/Drivers/Input/TITinyConTypes.h"
 
 #include <Arduino.h>
 #include <Adafruit_seesaw.h>
 #include <array>
+#include <utility>
 
 namespace TinyCon
 {
-    struct DebouncedButton
+    /**
+     * Debounces all buttons of an input at once on packed masks, one bit per button. Each button has a 3 bit vertical
+     * counter spread over three masks, so 32 buttons cost the same few bit operations as one. In eager mode, a change
+     * is reported on its first sample and the button is then ignored for Depth samples, which hides the bounce without
+     * adding latency. Otherwise a change is reported once the button read the same for Depth samples in a row.
+     */
+    class ButtonDebouncer
     {
-        bool History[4] = {};
-        int8_t Head = 0;
+    public:
+        static constexpr uint8_t MaxDepth = 7;
+
+        ButtonDebouncer() { Configure(ButtonDebounceDepth, ButtonDebounceEager); }
+
+        void Configure(uint8_t depth, bool eager);
+        /** Takes the raw pressed mask of one sample, returns the debounced one */
+        uint32_t Update(uint32_t raw);
+        void Reset() { State = Locked = 0; Counter = {}; }
+        [[nodiscard]] uint32_t Get() const { return State; }
+
+    private:
+        uint32_t State = 0;
+        // Eager mode, buttons ignored since their last change
+        uint32_t Locked = 0;
+        std::array<uint32_t, 3> Counter{};
+        uint8_t Depth = 1;
+        bool Eager = false;
 
-        void AddState(bool state) { History[Head] = state; Head = (Head + 1) & 3; }
-        [[nodiscard]] bool StateAt(int8_t index) const { index = (4 + Head - index) & 3; return History[index]; }
-        [[nodiscard]] bool Get() const;
+        /** Counts the buttons in the mask up by one and clears the others, returns the ones that reached Depth */
+        uint32_t Count(uint32_t mask);
     };
 
+    /**
+     * Joy FeatherWing on a Seesaw. Bring-up uses the Adafruit library, the per-frame reads go through the I2CQueue
+     * in split phases instead: each read is a register select, a conversion delay on the Seesaw and the actual read,
+     * so all pads get their select of a phase first and are read after a single shared delay. GamepadController runs
+     * the phases, Update then only applies what was read.
+     */
     class SeesawController
     {
     public:
-        void Init(TwoWire& i2c, int8_t controller);
+        enum class Phases : uint8_t { Flags = 0, Buttons, Axis0, Axis1, Count };
+        static constexpr uint8_t PhaseCount = static_cast<uint8_t>(Phases::Count);
+        // The delays the Adafruit library uses, the ADC one is per channel, since each read starts a new conversion
+        static constexpr uint16_t DefaultReadDelay = 250;
+        static constexpr uint16_t DefaultAdcDelay = 500;
+        // Pads fill the 4 addresses of the bus, then those of each mux channel in turn
+        static constexpr int8_t ControllersPerBus = 4;
+        static constexpr int8_t MaxControllers = SeesawPadCount;
+        static_assert(MaxControllers <= ControllersPerBus * (I2CMuxChannelCount > 0 ? I2CMuxChannelCount : 1), "Not enough addresses for the pads");
+
+        void Init(TwoWire& i2c, I2CQueue& queue, DiscoveryService& discovery, int8_t controller, int8_t interruptPin = NC);
         void Update();
 
-        float Axis[2] = {};
-        DebouncedButton Buttons[5] = {};
+        /** Decides which phases this update needs, call once before the first Request */
+        void Prepare();
+        /** Queues the register select of the phase, returns false if this update doesn't need it */
+        bool Request(Phases phase);
+        /** Queues reading the answer of the phase if it was requested, call once its delay passed */
+        void Collect(Phases phase);
+        /** Time in us the Seesaw needs between the select and the read of the phase */
+        [[nodiscard]] uint16_t GetDelay(Phases phase) const { return phase >= Phases::Axis0 ? AdcDelay : ReadDelay; }
+        void SetDelays(uint16_t readDelay, uint16_t adcDelay) { ReadDelay = readDelay; AdcDelay = adcDelay; }
+        [[nodiscard]] I2CAddress GetAddress() const { return GetAddress(Controller); }
+        /** Pads fill the mux channels in order, ControllersPerBus to a channel */
+        [[nodiscard]] static constexpr I2CAddress GetAddress(int8_t controller)
+        { return MakeI2CAddress(AddressByController[controller % ControllersPerBus], I2CMuxChannelCount > 0 ? controller / ControllersPerBus : NoI2CChannel); }
+        /** The hardware ID, read back like any other Seesaw register */
+        [[nodiscard]] BusCalibration GetCalibration() const { return {GetAddress(), {SEESAW_STATUS_BASE, SEESAW_STATUS_HW_ID}, 2, 1, ReadDelay}; }
+
+        /** True if any Seesaw signalled a button change on its INT line that has not been read yet */
+        [[nodiscard]] static bool IsInterruptPending();
+
+        // Raw readings in Q15, calibration and shaping is up to the InputController
+        int16_t Axis[2] = {};
+        ButtonDebouncer Buttons;
         bool Present = false;
+        // micros() when the raw button state last changed, the INT edge in interrupt mode
+        uint32_t EdgeTime = 0;
 
         // Special call to just update a single special button
         [[nodiscard]] bool GetUpdatedButton(int8_t index) const;
+        [[nodiscard]] static constexpr int16_t GetButtonCount() { return InputButtonCount; }
+        /** True if a button change wakes the firmware, so the button doesn't need to be polled while suspended */
+        [[nodiscard]] bool CanWake() const { return InterruptPin != NC; }
 
         void Reset();
     private:
         // Make this mutable, because the Adafruit seesaw library is not const-correct for read functions
         mutable Adafruit_seesaw Device;
+        TwoWire* I2C = nullptr;
+        I2CQueue* Queue = nullptr;
+        DeviceInit InitState;
         int8_t Controller = -1;
+        int8_t InterruptPin = NC;
+        uint32_t ButtonStates = 0;
+        uint32_t LastButtonTime = 0;
+        uint32_t LastAxisTime = 0;
+        uint16_t ReadDelay = DefaultReadDelay;
+        uint16_t AdcDelay = DefaultAdcDelay;
 
-        static constexpr int8_t AddressByController[] = {0x49, 0x4A, 0x4B, 0x4C};
+        // Phases needed, read and failed in the current update, one bit per phase
+        uint8_t Needed = 0;
+        uint8_t Collected = 0;
+        uint8_t Failed = 0;
+        uint32_t SampleTime = 0;
+        uint8_t Rx[PhaseCount][4] = {};
+
+        static constexpr uint8_t AddressByController[ControllersPerBus] = {0x49, 0x4A, 0x4B, 0x4C};
+        // In interrupt mode, axis are sampled on their own cadence and buttons are re-read periodically even without
+        // an interrupt, so a Seesaw that lost its interrupt config after a reset is still detected.
+        static constexpr uint32_t AxisInterval = 10;
+        static constexpr uint32_t ButtonResyncInterval = 100;
+        // The Seesaw needs a moment to reboot after a software reset before it acknowledges its address again
+        static constexpr uint32_t ResetTime = 10;
+        static constexpr uint8_t ResetRetries = 10;
         static constexpr uint8_t InputAxis[] = {2, 3};
+        // ADC channels of the axis pins on the SAMD09, the library maps them the same way in analogRead
+        static constexpr uint8_t InputAxisChannels[] = {0, 1};
         static constexpr int32_t InputAxisCount = sizeof(InputAxis) / sizeof(InputAxis[0]);
+        static_assert(InputAxisCount == PhaseCount - static_cast<uint8_t>(Phases::Axis0), "One read phase per axis");
         static constexpr uint8_t InputButtonRight = 6;
         static constexpr uint8_t InputButtonDown = 7;
         static constexpr uint8_t InputButtonLeft = 9;
@@ -52,7 +145,28 @@ namespace TinyCon
         static constexpr uint32_t InputButtonMask = InputButtons[0] | InputButtons[1] | InputButtons[2] | InputButtons[3] | InputButtons[4];
         static constexpr int32_t InputButtonCount = sizeof(InputButtons) / sizeof(InputButtons[0]);
 
-        void Init();
+        static volatile bool InterruptPending[MaxControllers];
+        static volatile uint32_t InterruptTime[MaxControllers];
+        template <int8_t CController> static void OnInterrupt()
+        {
+            InterruptTime[CController] = micros();
+            InterruptPending[CController] = true;
+            WakeController::Signal(WakeController::WakeInput);
+        }
+        template <std::size_t... CControllers>
+        static constexpr std::array<void (*)(), sizeof...(CControllers)> MakeInterruptHandlers(std::index_sequence<CControllers...>)
+        { return {&OnInterrupt<CControllers>...}; }
+        static const std::array<void (*)(), MaxControllers> InterruptHandlers;
+
+        static void OnCollected(void* context, const I2CTransaction& transaction);
+
+        void Configure();
+        void UpdateInit();
+        void ReadButtons(bool clearInterrupt);
+        void ReadAxis();
+
+        /** The Seesaw ADC is 10 bits */
+        static int16_t ToQ15(int32_t value) { return static_cast<int16_t>((Tiny::Math::Min(value, 1023) << 6) - 32768); }
     };
 
     class PinsInputController
@@ -67,9 +181,14 @@ namespace TinyCon
         void Init(const std::array<int8_t, MaxNativeAdcPinCount>& axisPins, const std::array<int8_t, MaxNativeGpioPinCount>& buttonPins, ActiveState activeState);
         void Update();
 
-        float Axis[2] = {};
-        DebouncedButton Buttons[5] = {};
+        // Raw readings in Q15, calibration and shaping is up to the InputController
+        int16_t Axis[MaxNativeAdcPinCount] = {};
+        // Axis holds readings, on the nRF only once the first scan was collected, until then it is all zeros
+        bool AxisValid = false;
+        ButtonDebouncer Buttons;
         bool Present = false;
+        // micros() of the update that first saw the raw button state change
+        uint32_t EdgeTime = 0;
 
         // Special call to just update a single special button
         [[nodiscard]] bool GetUpdatedButton(int8_t index) const;
@@ -78,39 +197,91 @@ namespace TinyCon
         [[nodiscard]] int16_t GetButtonCount() const { return ButtonCount; }
 
     private:
-        std::array<int8_t, 2> AxisPins = {NC};
+        std::array<int8_t, MaxNativeAdcPinCount> AxisPins = {};
         int16_t AxisCount = 0;
-        std::array<int8_t, 5> ButtonPins = {NC};
+        std::array<int8_t, MaxNativeGpioPinCount> ButtonPins = {};
         int16_t ButtonCount = 0;
         ActiveState ButtonActiveState = ActiveState::Low;
+        uint32_t RawButtons = 0;
+
+    #if defined(NRF52840_XXAA) || defined(NRF52832_XXAA)
+        // Buttons are read straight from the port IN registers, all of them with one read per port
+        std::array<uint8_t, MaxNativeGpioPinCount> ButtonPortPins = {};
+        uint32_t ButtonInvert = 0;
+        // The axis are converted by the SAADC in scan mode, one channel per axis. A scan is started at the end of
+        // each update and collected at the start of the next one, while the next scan goes to the other buffer.
+        std::array<uint32_t, MaxNativeAdcPinCount> AxisInputs = {};
+        int16_t AxisBuffers[2][MaxNativeAdcPinCount] = {};
+        uint8_t AxisBuffer = 0;
+        bool Scanning = false;
+
+        static uint32_t GetAnalogInput(uint32_t pin);
+        void StartScan();
+        /** Returns false while the scan is still running */
+        bool CollectScan();
+    #endif
     };
 
     class InputController
     {
     public:
+        static constexpr int8_t MaxAxisCount = 8;
+
         InputController() {};
         ~InputController() { if (Type == Tiny::Drivers::Input::TITinyConControllerTypes::Seesaw) Seesaw.~SeesawController(); }
 
-        void Init(TwoWire& i2c, int8_t controller);
+        void Init(TwoWire& i2c, I2CQueue& queue, DiscoveryService& discovery, int8_t controller);
         void Init(const std::array<int8_t, MaxNativeAdcPinCount>& axisPins, const std::array<int8_t, MaxNativeGpioPinCount>& buttonPins, ActiveState activeState);
+        /** Takes one sample, the reported axis and buttons only change in Decimate */
         void Update();
+        /** Decimates the samples since the last call into the reported axis and buttons, call once per report */
+        void Decimate();
         void Reset();
 
         [[nodiscard]] Tiny::Drivers::Input::TITinyConControllerTypes GetType() const;
         [[nodiscard]] int16_t GetAxisCount() const;
         [[nodiscard]] int16_t GetButtonCount() const;
 
-        [[nodiscard]] float GetAxis(int8_t index) const { return Axis[index]; }
-        [[nodiscard]] bool GetButton(int8_t index) const { return Buttons[index]; }
+        /** Calibrated and shaped, in Q15 */
+        [[nodiscard]] int16_t GetAxis(int8_t index) const { return Axis[index]; }
+        [[nodiscard]] AxisProcessor& GetAxisProcessor(int8_t index) { return AxisProcessors[index]; }
+        [[nodiscard]] bool GetButton(int8_t index) const { return (Buttons >> index) & 1; }
         [[nodiscard]] bool GetUpdatedButton(int8_t index) const;
+        [[nodiscard]] bool CanWake() const;
+        /** The Seesaw driver, if this is a Seesaw that is present, for running the split read phases */
+        [[nodiscard]] SeesawController* GetSeesaw();
+        /** Empty if the input is not on the I2C0 bus or not present */
+        [[nodiscard]] BusCalibration GetCalibration() const;
+        void SetDebounce(uint8_t depth, bool eager);
+        void SetDecimation(InputDecimations decimation) { Decimation = decimation; SampleCount = 0; }
+        [[nodiscard]] InputDecimations GetDecimation() const { return Decimation; }
+        void SetSeesawDelays(uint16_t readDelay, uint16_t adcDelay)
+        { if (Type == Tiny::Drivers::Input::TITinyConControllerTypes::Seesaw) Seesaw.SetDelays(readDelay, adcDelay); }
 
         bool Enabled = true;
         bool Present = false;
-        float Axis[8] = {};
-        bool Buttons[32] = {};
+        int16_t Axis[MaxAxisCount] = {};
+        // Reported pressed state, one bit per button, the debounced state of the last sample plus any taps in between
+        uint32_t Buttons = 0;
+        // Edge time of the raw sample behind the last debounced button change, for latency tracing
+        uint32_t Timestamp = 0;
 
     private:
         Tiny::Drivers::Input::TITinyConControllerTypes Type = Tiny::Drivers::Input::TITinyConControllerTypes::None;
+        std::array<AxisProcessor, MaxAxisCount> AxisProcessors{};
+
+        // Raw samples since the last Decimate, the sum for Average, the extremes for Peak and the last one for Latest
+        InputDecimations Decimation = InputDecimation;
+        uint16_t SampleCount = 0;
+        int32_t AxisSum[MaxAxisCount] = {};
+        int16_t AxisMin[MaxAxisCount] = {};
+        int16_t AxisMax[MaxAxisCount] = {};
+        int16_t AxisLatest[MaxAxisCount] = {};
+        // Debounced buttons of the last sample and every button pressed at any sample since the last Decimate
+        uint32_t SampledButtons = 0;
+        uint32_t HeldButtons = 0;
+
+        void Sample(const int16_t* raw, int16_t count);
         union
         {
             PinsInputController Pins;
@@ -1,39 +1,288 @@
 #include "MpuController.h"
 
-void TinyCon::MpuController::Init(TwoWire& i2c, int8_t controller)
+#include <cmath>
+
+volatile uint32_t TinyCon::MpuController::EdgeCount[MaxControllers] = {};
+volatile uint32_t TinyCon::MpuController::EdgeTimes[MaxControllers][EdgeDepth] = {};
+const std::array<void (*)(), TinyCon::MpuController::MaxControllers> TinyCon::MpuController::InterruptHandlers =
+    MakeInterruptHandlers(std::make_index_sequence<MaxControllers>());
+
+void TinyCon::MpuController::Init(I2CQueue& queue, DiscoveryService& discovery, int8_t controller, int8_t interruptPin)
 {
-    I2C = &i2c;
+    Queue = &queue;
     Controller = controller;
+    InterruptPin = Controller < MaxControllers ? interruptPin : NC;
+    if (InterruptPin != NC)
+    {
+        pinMode(InterruptPin, INPUT);
+        attachInterrupt(digitalPinToInterrupt(InterruptPin), InterruptHandlers[Controller], RISING);
+    }
+    Fusion.Configure(MpuFusionProportionalGain, MpuFusionIntegralGain, SamplePeriod * 1e-6f);
+    Bias.Configure(SamplePeriod);
+    // A known IMU is corrected from its first sample on
+    if (Controller < MaxControllers) Bias.Load(Controller);
+    // The sweep's probe would read a byte out of the FIFO, a sensor that stops answering is noticed by the drain
+    // instead
+    if (Controller < MaxControllers) discovery.Watch(GetAddress(), InitState, true);
 }
 
 void TinyCon::MpuController::Update()
 {
-    if (!Icm20948Present)
+    // The discovery service saw the sensor depart
+    if (Present && !InitState.Is(DeviceStates::Present)) Present = false;
+    if (!Present)
     {
-        if (Controller < ICM20948AddressByControllerSize)
-        {
-            const auto address = ICM20948AddressByController[Controller];
-            I2C->beginTransmission(address);
-            if (I2C->endTransmission() == 0 && (Icm20948Present = Icm20948.begin_I2C(address, I2C)))
-            {
-                delay(100);
-                SetAccelerometerRange(AccelerationRange);
-                SetGyroscopeRange(GyroscopeRange);
-                Icm20948.setMagDataRate(AK09916_MAG_DATARATE_50_HZ);
-                Present = true;
-                delay(10);
-            }
-        }
+        UpdateInit();
+        return;
+    }
+    if (Failed)
+    {
+        // A sensor that stopped answering was unplugged or lost power, bring it up again from scratch
+        Failed = false;
+        Present = false;
+        InitState.Lost();
+        return;
     }
-    else
+
+    // The fill level decides how much the burst reads, OnFifoCount queues it right behind
+    BatchSize = 0;
+    Queue->WriteRead(GetAddress(), {RegisterFifoCount}, FifoCountRx, sizeof(FifoCountRx), OnFifoCount, this);
+
+    // The AK09916 measures at its own rate, nothing to read until its next measurement can be there, and nothing at all
+    // if neither the fusion nor the host wants the magnetic field
+    NewMagneticField = false;
+    const auto time = micros();
+    if ((MpuFusionMagnetometer || OrientationEnabled || MagnetometerCountEnabled) && time - MagnetometerTime >= MagnetometerReadInterval)
     {
-        // Grab latest MPU values
-        sensors_event_t accelerationEvent, angularVelocityEvent, orientationEvent, temperatureEvent;
-        Icm20948.getEvent(&accelerationEvent, &angularVelocityEvent, &temperatureEvent, &orientationEvent);
-        Acceleration = {accelerationEvent.acceleration.x, accelerationEvent.acceleration.y, accelerationEvent.acceleration.z};
-        AngularVelocity = {angularVelocityEvent.gyro.x, angularVelocityEvent.gyro.y, angularVelocityEvent.gyro.z};
-        Orientation = {orientationEvent.orientation.x, orientationEvent.orientation.y, orientationEvent.orientation.z};
-        Temperature = temperatureEvent.temperature;
+        MagnetometerReadTime = time;
+        Queue->WriteRead(GetAddress(), {RegisterExternalData}, MagnetometerRx, sizeof(MagnetometerRx), OnMagnetometer, this);
+    }
+}
+
+void TinyCon::MpuController::OnFifoCount(void* context, const I2CTransaction& transaction)
+{
+    auto& mpu = *static_cast<MpuController*>(context);
+    if (!transaction.Success)
+    {
+        mpu.Failed = true;
+        return;
+    }
+
+    mpu.DrainTime = micros();
+    const uint32_t edges = EdgeCount[mpu.Controller];
+    const auto count = static_cast<uint16_t>((mpu.FifoCountRx[0] & 0x1F) << 8 | mpu.FifoCountRx[1]);
+    // A full FIFO stopped being whole samples at the point it overflowed, there is no telling where the next one starts
+    if (count > FifoSize - PacketSize)
+    {
+        ++mpu.Overflows;
+        mpu.ResetFifo();
+        return;
+    }
+
+    const auto available = count / PacketSize;
+    const auto samples = Tiny::Math::Min<uint16_t, uint16_t>(available, MaxBatchSize);
+    mpu.Remaining = available - samples;
+    if (mpu.InterruptPin != NC)
+    {
+        // Every sample drained or still in the FIFO raised its edge, any edge beyond those came after the read
+        const auto firstEdge = edges - mpu.Drained - available;
+        if (!mpu.EdgesSynced || static_cast<int32_t>(firstEdge - mpu.FirstEdge) < 0) mpu.FirstEdge = firstEdge;
+        mpu.EdgesSynced = true;
+    }
+    if (samples) mpu.Queue->WriteRead(mpu.GetAddress(), {RegisterFifoData}, mpu.FifoRx, samples * PacketSize, OnFifoData, context);
+}
+
+void TinyCon::MpuController::OnFifoData(void* context, const I2CTransaction& transaction)
+{
+    auto& mpu = *static_cast<MpuController*>(context);
+    if (!transaction.Success)
+    {
+        // A burst that broke off may have taken part of a sample, there is no telling where the next one starts
+        mpu.ResetFifo();
+        return;
+    }
+
+    const auto samples = static_cast<uint8_t>(transaction.RxSize / PacketSize);
+    const auto value = [](const uint8_t* data) { return static_cast<int16_t>(data[0] << 8 | data[1]); };
+    // The AK09916 has its Y and Z axis the other way around than the accelerometer and gyroscope
+    const auto& field = mpu.MagneticField;
+    const auto magneticField = MpuFusionMagnetometer ? Tiny::Math::TIVector3F{1.0f * field.X, -1.0f * field.Y, -1.0f * field.Z} : Tiny::Math::TIVector3F{};
+    // The temperature hardly changes within a batch, the bias at the newest sample's does for all of them
+    mpu.AngularVelocityBias = mpu.Bias.Get(value(mpu.FifoRx + (samples - 1) * PacketSize + 12) * TemperatureScale + TemperatureOffset);
+    for (uint8_t i = 0; i < samples; ++i)
+    {
+        const auto* packet = mpu.FifoRx + i * PacketSize;
+        auto& sample = mpu.Batch[i];
+        sample.Acceleration = {value(packet), value(packet + 2), value(packet + 4)};
+        sample.AngularVelocity = {value(packet + 6), value(packet + 8), value(packet + 10)};
+        sample.Temperature = value(packet + 12);
+        if (MpuBiasLearning) mpu.Bias.Update(Scale(sample.AngularVelocity, mpu.AngularVelocityScale), mpu.GetAcceleration(sample), GetTemperature(sample));
+        // The fusion doesn't care for the unit of the acceleration, only the angular velocity has to be scaled
+        mpu.Fusion.Update({1.0f * sample.Acceleration.X, 1.0f * sample.Acceleration.Y, 1.0f * sample.Acceleration.Z}, mpu.GetAngularVelocity(sample), magneticField);
+        sample.Quaternion = mpu.Fusion.GetOrientation();
+        // The newest sample in the FIFO was taken within the last period, the ones before it one period apart each
+        const auto derived = mpu.DrainTime - (mpu.Remaining + samples - 1 - i) * SamplePeriod;
+        sample.Timestamp = mpu.InterruptPin != NC ? mpu.GetEdgeTime(mpu.FirstEdge + mpu.Drained + i, derived) : derived;
+    }
+    mpu.BatchSize = samples;
+    mpu.Drained += samples;
+    mpu.Latest = mpu.Batch[samples - 1];
+}
+
+Tiny::Math::TIVector3F TinyCon::MpuController::GetAngularVelocity(const Sample& sample) const
+{
+    const auto angularVelocity = Scale(sample.AngularVelocity, AngularVelocityScale);
+    return {angularVelocity.X - AngularVelocityBias.X, angularVelocity.Y - AngularVelocityBias.Y, angularVelocity.Z - AngularVelocityBias.Z};
+}
+
+void TinyCon::MpuController::SaveGyroBias()
+{
+    // Flash wears out, a bias that was only refined is written every so often, a new temperature right away
+    if (!Bias.IsChanged() || (!Bias.IsExtended() && millis() - BiasSaveTime < MpuBiasSaveInterval)) return;
+    BiasSaveTime = millis();
+    Bias.Save(Controller);
+}
+
+uint32_t TinyCon::MpuController::GetEdgeTime(uint32_t edge, uint32_t fallback) const
+{
+    // The interrupt keeps counting, the entry is only valid while fewer than EdgeDepth edges came after it
+    const auto time = EdgeTimes[Controller][edge & (EdgeDepth - 1)];
+    const auto newer = EdgeCount[Controller] - edge;
+    return newer >= 1 && newer <= EdgeDepth ? time : fallback;
+}
+
+void TinyCon::MpuController::OnMagnetometer(void* context, const I2CTransaction& transaction)
+{
+    auto& mpu = *static_cast<MpuController*>(context);
+    if (!transaction.Success) return;
+
+    // ST1, then the axis little-endian, a dummy and ST2. The registers keep the last reading until the I2C master sees
+    // a new one, whose data ready flag only shows in the first reading of the master. A flag missed in between still
+    // shows in the values, the noise changes them with every measurement.
+    const auto* rx = mpu.MagnetometerRx + 1;
+    const auto value = [](const uint8_t* data) { return static_cast<int16_t>(data[1] << 8 | data[0]); };
+    const RawVector field = {value(rx), value(rx + 2), value(rx + 4)};
+    const auto same = field.X == mpu.MagneticField.X && field.Y == mpu.MagneticField.Y && field.Z == mpu.MagneticField.Z;
+    if ((!(mpu.MagnetometerRx[0] & MagnetometerDataReady) && same) || (mpu.MagnetometerRx[8] & MagnetometerOverflow))
+    {
+        ++mpu.StaleMagnetometerReads;
+        return;
+    }
+
+    mpu.MagneticField = field;
+    mpu.MagnetometerTime = mpu.MagnetometerReadTime;
+    mpu.NewMagneticField = true;
+    ++mpu.MagnetometerCount;
+}
+
+bool TinyCon::MpuController::Identify()
+{
+    // The bank is unknown after a reset of the controller, not after one of the sensor
+    uint8_t whoAmI = 0;
+    SelectBank(0);
+    Queue->WriteRead(GetAddress(), {RegisterWhoAmI}, &whoAmI, 1);
+    Queue->Flush();
+    return whoAmI == WhoAmI;
+}
+
+void TinyCon::MpuController::Wake()
+{
+    Queue->Write(GetAddress(), {RegisterPowerManagement1, PowerAutoClock});
+    Queue->Write(GetAddress(), {RegisterPowerManagement2, 0});
+    Queue->Write(GetAddress(), {RegisterUserControl, UserControlMaster});
+    SelectBank(3);
+    Queue->Write(GetAddress(), {Register3MasterControl, MasterClock});
+    // Only slave 0 is slowed down, slave 4 writes go out on the next sample
+    Queue->Write(GetAddress(), {Register3MasterDelay, 0x01});
+    WriteMagnetometer(MagnetometerControl3, MagnetometerReset);
+    SelectBank(0);
+}
+
+void TinyCon::MpuController::Configure()
+{
+    SelectBank(3);
+    WriteMagnetometer(MagnetometerControl2, MagnetometerMode);
+    Queue->Write(GetAddress(), {Register3Slave0Address, SlaveRead | MagnetometerAddress, MagnetometerStatus1, SlaveEnable | MagnetometerSize});
+
+    // Both sensors at the same rate and aligned, so every FIFO sample is one accelerometer and one gyroscope reading
+    SelectBank(2);
+    Queue->Write(GetAddress(), {Register2GyroRateDivider, MpuSampleRateDivider});
+    Queue->Write(GetAddress(), {Register2OdrAlign, 1});
+    Queue->Write(GetAddress(), {Register2AccelRateDivider, 0, MpuSampleRateDivider});
+    SelectBank(0);
+    WriteAccelerometerRange();
+    WriteGyroscopeRange();
+    if (InterruptPin != NC)
+    {
+        Queue->Write(GetAddress(), {RegisterInterruptPin, InterruptPulse});
+        Queue->Write(GetAddress(), {RegisterInterruptEnable1, InterruptRawDataReady});
+    }
+    Queue->Write(GetAddress(), {RegisterFifoEnable2, FifoEnableSamples});
+    Queue->Write(GetAddress(), {RegisterFifoMode, 0});
+    Queue->Write(GetAddress(), {RegisterUserControl, UserControlFifo | UserControlMaster});
+    ResetFifo();
+}
+
+void TinyCon::MpuController::WriteMagnetometer(uint8_t reg, uint8_t value)
+{
+    // Address, register, control and data out follow each other, enabling the slave starts the transfer
+    Queue->Write(GetAddress(), {Register3Slave4Address, MagnetometerAddress, reg, SlaveEnable | MagnetometerDelay, value});
+}
+
+void TinyCon::MpuController::ResetFifo()
+{
+    // The edges are matched to the samples anew from the next fill level
+    Drained = 0;
+    EdgesSynced = false;
+    Queue->Write(GetAddress(), {RegisterFifoReset, FifoResetAll});
+    Queue->Write(GetAddress(), {RegisterFifoReset, 0});
+}
+
+void TinyCon::MpuController::UpdateInit()
+{
+    if (Controller >= MaxControllers || !InitState.Ready()) return;
+
+    switch (InitState.State)
+    {
+        case DeviceStates::Absent:
+            // A missing sensor costs nothing here, the discovery service moves it on to Probing once it answers
+            break;
+        case DeviceStates::Probing:
+            if (!Identify())
+            {
+                InitState.Lost();
+                break;
+            }
+            Queue->Write(GetAddress(), {RegisterPowerManagement1, PowerReset});
+            InitState.Wait(DeviceStates::Resetting, ResetTime);
+            break;
+        case DeviceStates::Resetting:
+            if (Identify())
+            {
+                Wake();
+                InitState.Wait(DeviceStates::Configuring, 10);
+            }
+            else if (InitState.Retries < ResetRetries) InitState.Retry(ResetTime);
+            else InitState.Lost();
+            break;
+        case DeviceStates::Configuring:
+            Configure();
+            InitState.Wait(DeviceStates::Settling, 10);
+            break;
+        case DeviceStates::Settling:
+            // It may be a different sensor or mounted differently, the orientation starts over from gravity
+            Fusion.Reset();
+            Bias.Restart();
+            Latest = {};
+            MagneticField = {};
+            MagnetometerCount = 0;
+            Failed = false;
+            InitState.Set(DeviceStates::Present);
+            Present = true;
+            break;
+        default:
+            InitState.Lost();
+            break;
     }
 }
 
@@ -41,77 +290,175 @@ std::size_t TinyCon::MpuController::FillBuffer(Tiny::Collections::TIFixedSpan<ui
 {
     auto size = 0;
     auto* current = const_cast<uint8_t*>(data.data());
+    // Only what is sent is scaled
     if (AccelerationEnabled)
     {
-        FillHalf(current, Acceleration.X);
-        FillHalf(current, Acceleration.Y);
-        FillHalf(current, Acceleration.Z);
+        const auto acceleration = GetAcceleration();
+        FillHalf(current, acceleration.X);
+        FillHalf(current, acceleration.Y);
+        FillHalf(current, acceleration.Z);
         size += 6;
     }
     if (AngularVelocityEnabled)
     {
-        FillHalf(current, AngularVelocity.X);
-        FillHalf(current, AngularVelocity.Y);
-        FillHalf(current, AngularVelocity.Z);
+        const auto angularVelocity = GetAngularVelocity();
+        FillHalf(current, angularVelocity.X);
+        FillHalf(current, angularVelocity.Y);
+        FillHalf(current, angularVelocity.Z);
         size += 6;
     }
     if (OrientationEnabled)
     {
-        FillHalf(current , Orientation.X);
-        FillHalf(current , Orientation.Y);
-        FillHalf(current , Orientation.Z);
+        const auto orientation = GetOrientation();
+        FillHalf(current , orientation.X);
+        FillHalf(current , orientation.Y);
+        FillHalf(current , orientation.Z);
         size += 6;
     }
     if (TemperatureEnabled)
     {
-        FillHalf(current , Temperature);
+        FillHalf(current , GetTemperature());
         size += 2;
     }
+    if (QuaternionEnabled)
+    {
+        FillHalf(current, Latest.Quaternion.W);
+        FillHalf(current, Latest.Quaternion.X);
+        FillHalf(current, Latest.Quaternion.Y);
+        FillHalf(current, Latest.Quaternion.Z);
+        size += 8;
+    }
+    if (TimestampEnabled)
+    {
+        FillUInt32(current, Latest.Timestamp);
+        size += TimestampSize;
+    }
+    if (MagnetometerCountEnabled)
+    {
+        FillInt16(current, static_cast<int16_t>(MagnetometerCount));
+        size += MagnetometerCountSize;
+    }
 
     return size;
 }
 
+std::size_t TinyCon::MpuController::FillRawBuffer(Tiny::Collections::TIFixedSpan<uint8_t> data) const
+{
+    auto* current = const_cast<uint8_t*>(data.data());
+    *current++ = static_cast<uint8_t>(GyroscopeRange) << 4 | static_cast<uint8_t>(AccelerationRange);
+    // Counts have nothing to round, but the bias is in rad/s and the quaternion in floats
+    const auto counts = [](float value) { return static_cast<int16_t>(Tiny::Math::Min(Tiny::Math::Max(lroundf(value), -32768l), 32767l)); };
+    if (AccelerationEnabled)
+    {
+        FillInt16(current, Latest.Acceleration.X);
+        FillInt16(current, Latest.Acceleration.Y);
+        FillInt16(current, Latest.Acceleration.Z);
+    }
+    if (AngularVelocityEnabled)
+    {
+        FillInt16(current, counts(Latest.AngularVelocity.X - AngularVelocityBias.X / AngularVelocityScale));
+        FillInt16(current, counts(Latest.AngularVelocity.Y - AngularVelocityBias.Y / AngularVelocityScale));
+        FillInt16(current, counts(Latest.AngularVelocity.Z - AngularVelocityBias.Z / AngularVelocityScale));
+    }
+    if (OrientationEnabled)
+    {
+        FillInt16(current, MagneticField.X);
+        FillInt16(current, MagneticField.Y);
+        FillInt16(current, MagneticField.Z);
+    }
+    if (TemperatureEnabled) FillInt16(current, Latest.Temperature);
+    if (QuaternionEnabled)
+    {
+        FillInt16(current, counts(Latest.Quaternion.W * 16384));
+        FillInt16(current, counts(Latest.Quaternion.X * 16384));
+        FillInt16(current, counts(Latest.Quaternion.Y * 16384));
+        FillInt16(current, counts(Latest.Quaternion.Z * 16384));
+    }
+    if (TimestampEnabled) FillUInt32(current, Latest.Timestamp);
+    if (MagnetometerCountEnabled) FillInt16(current, static_cast<int16_t>(MagnetometerCount));
+
+    return current - data.data();
+}
+
 void TinyCon::MpuController::SetAccelerometerRange(Tiny::Drivers::Input::TITinyConAccelerometerRanges range)
 {
     AccelerationRange = range;
-    if (Icm20948Present)
+    // Configure writes whatever range is set by then
+    if (InitState.State > DeviceStates::Configuring) WriteAccelerometerRange();
+    // Counts per g as in the datasheet
+    switch (range)
     {
-        switch (range)
-        {
-            case Tiny::Drivers::Input::TITinyConAccelerometerRanges::G2: Icm20948.setAccelRange(ICM20948_ACCEL_RANGE_2_G); break;
-            case Tiny::Drivers::Input::TITinyConAccelerometerRanges::G4: Icm20948.setAccelRange(ICM20948_ACCEL_RANGE_4_G); break;
-            case Tiny::Drivers::Input::TITinyConAccelerometerRanges::G8: Icm20948.setAccelRange(ICM20948_ACCEL_RANGE_8_G); break;
-            default: Icm20948.setAccelRange(ICM20948_ACCEL_RANGE_16_G); break;
-        }
+        case Tiny::Drivers::Input::TITinyConAccelerometerRanges::G2: AccelerationScale = 9.80665f / 16384; break;
+        case Tiny::Drivers::Input::TITinyConAccelerometerRanges::G4: AccelerationScale = 9.80665f / 8192; break;
+        case Tiny::Drivers::Input::TITinyConAccelerometerRanges::G8: AccelerationScale = 9.80665f / 4096; break;
+        default: AccelerationScale = 9.80665f / 2048; break;
     }
 }
 
 void TinyCon::MpuController::SetGyroscopeRange(Tiny::Drivers::Input::TITinyConGyroscopeRanges range)
 {
     GyroscopeRange = range;
-    if (Icm20948Present)
+    if (InitState.State > DeviceStates::Configuring) WriteGyroscopeRange();
+    // Counts per °/s as in the datasheet
+    switch (range)
+    {
+        case Tiny::Drivers::Input::TITinyConGyroscopeRanges::D250: AngularVelocityScale = 0.0174533f / 131; break;
+        case Tiny::Drivers::Input::TITinyConGyroscopeRanges::D500: AngularVelocityScale = 0.0174533f / 65.5f; break;
+        case Tiny::Drivers::Input::TITinyConGyroscopeRanges::D1000: AngularVelocityScale = 0.0174533f / 32.8f; break;
+        default: AngularVelocityScale = 0.0174533f / 16.4f; break;
+    }
+}
+
+void TinyCon::MpuController::WriteAccelerometerRange()
+{
+    uint8_t scale;
+    switch (AccelerationRange)
+    {
+        case Tiny::Drivers::Input::TITinyConAccelerometerRanges::G2: scale = 0; break;
+        case Tiny::Drivers::Input::TITinyConAccelerometerRanges::G4: scale = 1; break;
+        case Tiny::Drivers::Input::TITinyConAccelerometerRanges::G8: scale = 2; break;
+        default: scale = 3; break;
+    }
+    SelectBank(2);
+    Queue->Write(GetAddress(), {Register2AccelConfig, static_cast<uint8_t>(scale << 1 | ConfigFilter)});
+    SelectBank(0);
+}
+
+void TinyCon::MpuController::WriteGyroscopeRange()
+{
+    uint8_t scale;
+    switch (GyroscopeRange)
     {
-        switch (range)
-        {
-            case Tiny::Drivers::Input::TITinyConGyroscopeRanges::D250: Icm20948.setGyroRange(ICM20948_GYRO_RANGE_250_DPS); break;
-            case Tiny::Drivers::Input::TITinyConGyroscopeRanges::D500: Icm20948.setGyroRange(ICM20948_GYRO_RANGE_500_DPS); break;
-            case Tiny::Drivers::Input::TITinyConGyroscopeRanges::D1000: Icm20948.setGyroRange(ICM20948_GYRO_RANGE_1000_DPS); break;
-            default: Icm20948.setGyroRange(ICM20948_GYRO_RANGE_2000_DPS); break;
-        }
+        case Tiny::Drivers::Input::TITinyConGyroscopeRanges::D250: scale = 0; break;
+        case Tiny::Drivers::Input::TITinyConGyroscopeRanges::D500: scale = 1; break;
+        case Tiny::Drivers::Input::TITinyConGyroscopeRanges::D1000: scale = 2; break;
+        default: scale = 3; break;
     }
+    SelectBank(2);
+    Queue->Write(GetAddress(), {Register2GyroConfig, static_cast<uint8_t>(scale << 1 | ConfigFilter)});
+    SelectBank(0);
 }
 
 void TinyCon::MpuController::Reset()
 {
-    Present = Icm20948Present = false;
-    Acceleration = {0, 0, 0};
-    AngularVelocity = {0, 0, 0};
-    Orientation = {0, 0, 0};
-    Temperature = 0;
+    Present = false;
+    Failed = false;
+    InitState.Lost();
+    Latest = {};
+    MagneticField = {};
+    MagnetometerCount = 0;
+    NewMagneticField = false;
+    Fusion.Reset();
+    // The learned bias belongs to the sensor, not to the settings, it is kept
+    Bias.Restart();
+    BatchSize = 0;
     AccelerationEnabled = true;
     AngularVelocityEnabled = true;
     OrientationEnabled = true;
     TemperatureEnabled = true;
-    AccelerationRange = Tiny::Drivers::Input::TITinyConAccelerometerRanges::G16;
-    GyroscopeRange = Tiny::Drivers::Input::TITinyConGyroscopeRanges::D2000;
+    QuaternionEnabled = false;
+    TimestampEnabled = false;
+    MagnetometerCountEnabled = false;
+    SetAccelerometerRange(Tiny::Drivers::Input::TITinyConAccelerometerRanges::G16);
+    SetGyroscopeRange(Tiny::Drivers::Input::TITinyConGyroscopeRanges::D2000);
 }
@@ -1,50 +1,280 @@
 #pragma once
 
+#include "BusProfiles.h"
 #include "Config.h"
+#include "Discovery.h"
+#include "GyroBias.h"
+#include "I2CQueue.h"
+#include "OrientationFilter.h"
 #include "Utilities.h"
 
 #include "Core/Drivers/Input/TITinyConTypes.h"
+#include "Core/Math/TIQuaternion.h"
 #include "Core/Math/TIVector.h"
 #include "Core/Utilities/Collections/TISpan.h"
 
 #include <Arduino.h>
-#include <Adafruit_ICM20948.h>
+#include <array>
+#include <utility>
 
 namespace TinyCon
 {
+    /**
+     * ICM20948 with its AK09916 magnetometer, driven register by register through the I2CQueue. Accelerometer,
+     * gyroscope and temperature are sampled into the sensor's FIFO, the magnetometer is read by the sensor's own I2C
+     * master. The latest sample is what the reports send.
+     */
     class MpuController
     {
     public:
-        void Init(TwoWire& i2c, int8_t controller);
+        using RawVector = Tiny::Math::TIVector<int16_t, 3>;
+        /**
+         * One FIFO sample in counts as the sensor reports them, the Get* functions scale them to units where they are
+         * used
+         */
+        struct Sample
+        {
+            RawVector Acceleration = {};
+            RawVector AngularVelocity = {};
+            int16_t Temperature = 0;
+            // Fused up to and including this sample, the fusion runs at the sample rate whatever the update rate
+            Tiny::Math::TIQuaternionF Quaternion = {1, 0, 0, 0};
+            // micros() when the sensor took the sample. With the INT line wired every sample raises a data ready
+            // interrupt, and the samples are matched to those by counting them, which makes the timestamp exact.
+            // Without it, or for samples too old to still have theirs, it is derived from the fill level and the rate.
+            uint32_t Timestamp = 0;
+        };
+
+        // Acceleration, angular velocity and orientation as 3 half-floats each, temperature as one, the quaternion
+        // as 4, the timestamp as 4 bytes and the magnetometer count as 2
+        static constexpr std::size_t MaxBufferSize = 34;
+        static constexpr std::size_t TimestampSize = 4;
+        static constexpr std::size_t MagnetometerCountSize = 2;
+        // The same as 16 bit counts, after a header byte with the ranges
+        static constexpr std::size_t MaxRawBufferSize = MaxBufferSize + 1;
+        // Samples drained per update, whatever is left stays in the FIFO for the next one
+        static constexpr uint8_t MaxBatchSize = 16;
+        // The gyroscope sets the pace of the FIFO, the accelerometer is aligned to it
+        static constexpr uint32_t SamplePeriod = 1000000ul * (1 + MpuSampleRateDivider) / 1100;
+        // IMUs fill the 2 addresses of the bus, then those of each mux channel in turn
+        static constexpr int8_t ControllersPerBus = 2;
+        static constexpr int8_t MaxControllers = MpuCount;
+        static_assert(MaxControllers <= ControllersPerBus * (I2CMuxChannelCount > 0 ? I2CMuxChannelCount : 1), "Not enough addresses for the IMUs");
+
+        void Init(I2CQueue& queue, DiscoveryService& discovery, int8_t controller, int8_t interruptPin);
+        /**
+         * Brings the sensor up while it is not present, queues draining the FIFO once it is, flush the queue after.
+         * A drain is one read of the fill level and one burst of whole samples, each fused as it is drained.
+         */
         void Update();
         [[nodiscard]] std::size_t FillBuffer(Tiny::Collections::TIFixedSpan<uint8_t> data) const;
+        /** The enabled fields in counts, as in the Raw MPU format */
+        [[nodiscard]] std::size_t FillRawBuffer(Tiny::Collections::TIFixedSpan<uint8_t> data) const;
 
-        [[nodiscard]] Tiny::Drivers::Input::TITinyConMpuTypes GetType() const { return (Icm20948Present) ? Tiny::Drivers::Input::TITinyConMpuTypes::ICM20948 : Tiny::Drivers::Input::TITinyConMpuTypes::None; }
+        [[nodiscard]] Tiny::Drivers::Input::TITinyConMpuTypes GetType() const { return (Present) ? Tiny::Drivers::Input::TITinyConMpuTypes::ICM20948 : Tiny::Drivers::Input::TITinyConMpuTypes::None; }
         [[nodiscard]] Tiny::Drivers::Input::TITinyConAccelerometerRanges GetAccelerometerRange() const { return AccelerationRange; }
         void SetAccelerometerRange(Tiny::Drivers::Input::TITinyConAccelerometerRanges range);
         [[nodiscard]] Tiny::Drivers::Input::TITinyConGyroscopeRanges GetGyroscopeRange() const { return GyroscopeRange; }
         void SetGyroscopeRange(Tiny::Drivers::Input::TITinyConGyroscopeRanges range);
+        [[nodiscard]] I2CAddress GetAddress() const { return GetAddress(Controller); }
+        /** IMUs fill the mux channels in order, ControllersPerBus to a channel */
+        [[nodiscard]] static constexpr I2CAddress GetAddress(int8_t controller)
+        { return MakeI2CAddress(ICM20948AddressByController[controller % ControllersPerBus], I2CMuxChannelCount > 0 ? controller / ControllersPerBus : NoI2CChannel); }
+        /** WHO_AM_I, or whichever register the current bank has there, it only has to read back the same */
+        [[nodiscard]] BusCalibration GetCalibration() const { return {GetAddress(), {0x00}, 1, 1}; }
 
         bool Present = false;
         bool AccelerationEnabled = true;
         bool AngularVelocityEnabled = true;
         bool OrientationEnabled = true;
         bool TemperatureEnabled = true;
+        bool QuaternionEnabled = false;
+        bool TimestampEnabled = false;
+        bool MagnetometerCountEnabled = false;
 
-        Tiny::Math::TIVector3F Acceleration = {};
-        Tiny::Math::TIVector3F AngularVelocity = {};
-        Tiny::Math::TIVector3F Orientation = {};
-        float Temperature = 0;
+        /** The latest sample in m/s², rad/s, uT and °C, scaled by the current ranges */
+        [[nodiscard]] Tiny::Math::TIVector3F GetAcceleration() const { return GetAcceleration(Latest); }
+        [[nodiscard]] Tiny::Math::TIVector3F GetAngularVelocity() const { return GetAngularVelocity(Latest); }
+        [[nodiscard]] Tiny::Math::TIVector3F GetOrientation() const { return Scale(MagneticField, MagnetometerScale); }
+        [[nodiscard]] float GetTemperature() const { return GetTemperature(Latest); }
+        [[nodiscard]] const Tiny::Math::TIQuaternionF& GetQuaternion() const { return Latest.Quaternion; }
+        /** micros() when the latest sample was taken */
+        [[nodiscard]] uint32_t GetTimestamp() const { return Latest.Timestamp; }
+        /**
+         * Magnetometer readings taken since the sensor came up, wrapping, and whether the last update took one. A
+         * reading is only taken when its data ready flag or its values say it is new, the count tells hosts when.
+         */
+        [[nodiscard]] uint16_t GetMagnetometerCount() const { return MagnetometerCount; }
+        [[nodiscard]] bool HasNewOrientation() const { return NewMagneticField; }
+        /** Magnetometer reads that only found the reading taken before */
+        [[nodiscard]] uint32_t GetStaleMagnetometerCount() const { return StaleMagnetometerReads; }
+        [[nodiscard]] Tiny::Math::TIVector3F GetAcceleration(const Sample& sample) const { return Scale(sample.Acceleration, AccelerationScale); }
+        /** Less the gyroscope bias at the temperature of the last update */
+        [[nodiscard]] Tiny::Math::TIVector3F GetAngularVelocity(const Sample& sample) const;
+        [[nodiscard]] static float GetTemperature(const Sample& sample) { return sample.Temperature * TemperatureScale + TemperatureOffset; }
+
+        /** The samples drained by the last update, oldest first */
+        [[nodiscard]] uint8_t GetBatchSize() const { return BatchSize; }
+        [[nodiscard]] const Sample& GetSample(uint8_t index) const { return Batch[index]; }
+        /** FIFO overflows since the sensor came up, each of them loses the samples that were in the FIFO */
+        [[nodiscard]] uint32_t GetOverflowCount() const { return Overflows; }
+        /** The gyroscope bias subtracted from the angular velocity, in rad/s */
+        [[nodiscard]] const Tiny::Math::TIVector3F& GetAngularVelocityBias() const { return AngularVelocityBias; }
+        [[nodiscard]] const GyroBias& GetGyroBias() const { return Bias; }
+        /** Persists the bias table once it learned a new temperature, or MpuBiasSaveInterval after it last changed */
+        void SaveGyroBias();
+        /** Whether the timestamps come from the data ready interrupt */
+        [[nodiscard]] bool HasInterrupt() const { return InterruptPin != NC; }
 
         void Reset();
     private:
-        static constexpr int8_t ICM20948AddressByController[] = {0x68, 0x69};
-        static constexpr int8_t ICM20948AddressByControllerSize = sizeof(ICM20948AddressByController) / sizeof(ICM20948AddressByController[0]);
-        TwoWire* I2C;
+        static constexpr uint8_t ICM20948AddressByController[ControllersPerBus] = {0x68, 0x69};
+        static constexpr uint8_t WhoAmI = 0xEA;
+        // The reset takes the sensor off the bus for a moment, it is polled for until it answers again
+        static constexpr uint32_t ResetTime = 20;
+        static constexpr uint8_t ResetRetries = 10;
+        // Registers of bank 0, where the sensor is left between steps, bank 2 and 3 are selected around their writes
+        static constexpr uint8_t RegisterWhoAmI = 0x00;
+        static constexpr uint8_t RegisterUserControl = 0x03;
+        static constexpr uint8_t RegisterPowerManagement1 = 0x06;
+        static constexpr uint8_t RegisterPowerManagement2 = 0x07;
+        static constexpr uint8_t RegisterInterruptPin = 0x0F;
+        static constexpr uint8_t RegisterInterruptEnable1 = 0x11;
+        static constexpr uint8_t RegisterExternalData = 0x3B;
+        static constexpr uint8_t RegisterFifoEnable2 = 0x67;
+        static constexpr uint8_t RegisterFifoReset = 0x68;
+        static constexpr uint8_t RegisterFifoMode = 0x69;
+        static constexpr uint8_t RegisterFifoCount = 0x70;
+        static constexpr uint8_t RegisterFifoData = 0x72;
+        static constexpr uint8_t RegisterBankSelect = 0x7F;
+        static constexpr uint8_t Register2GyroRateDivider = 0x00;
+        static constexpr uint8_t Register2GyroConfig = 0x01;
+        static constexpr uint8_t Register2OdrAlign = 0x09;
+        static constexpr uint8_t Register2AccelRateDivider = 0x10;
+        static constexpr uint8_t Register2AccelConfig = 0x14;
+        static constexpr uint8_t Register3MasterControl = 0x01;
+        static constexpr uint8_t Register3MasterDelay = 0x02;
+        static constexpr uint8_t Register3Slave0Address = 0x03;
+        static constexpr uint8_t Register3Slave4Address = 0x13;
+        static constexpr uint8_t PowerReset = 0x80;
+        // Best available clock, all sensors on
+        static constexpr uint8_t PowerAutoClock = 0x01;
+        // Active high, push-pull and a 50us pulse per sample, nothing to acknowledge
+        static constexpr uint8_t InterruptPulse = 0x00;
+        static constexpr uint8_t InterruptRawDataReady = 0x01;
+        // Data ready edges remembered per sensor, a power of two. An update drains a few samples, so older samples only
+        // lose their edges after the FIFO backed up, and fall back to the derived timestamps then.
+        static constexpr uint8_t EdgeDepth = 32;
+        static constexpr uint8_t UserControlFifo = 0x40;
+        static constexpr uint8_t UserControlMaster = 0x20;
+        // 345.6kHz on the auxiliary bus, as the datasheet recommends
+        static constexpr uint8_t MasterClock = 0x07;
+        static constexpr uint8_t SlaveRead = 0x80;
+        static constexpr uint8_t SlaveEnable = 0x80;
+        // The low pass filter on, which the rate dividers need, full scale range in bit 1 and 2 of both config
+        // registers
+        static constexpr uint8_t ConfigFilter = 0x01;
+        // Accelerometer, all gyroscope axis and temperature, at MpuSampleRateDivider
+        static constexpr uint8_t FifoEnableSamples = 0x1F;
+        static constexpr uint8_t FifoResetAll = 0x1F;
+        static constexpr uint16_t FifoSize = 512;
+        // Big-endian accelerometer, gyroscope and temperature, in register order
+        static constexpr uint8_t PacketSize = 14;
+        // The AK09916 sits behind the sensor's I2C master, ST1 up to ST2 are read into the external sensor registers
+        static constexpr uint8_t MagnetometerAddress = 0x0C;
+        static constexpr uint8_t MagnetometerStatus1 = 0x10;
+        static constexpr uint8_t MagnetometerControl2 = 0x31;
+        static constexpr uint8_t MagnetometerControl3 = 0x32;
+        static constexpr uint8_t MagnetometerDataReady = 0x01;
+        static constexpr uint8_t MagnetometerOverflow = 0x08;
+        static constexpr uint8_t MagnetometerReset = 0x01;
+        // Continuous measurement at 50Hz
+        static constexpr uint8_t MagnetometerMode = 0x06;
+        static constexpr uint8_t MagnetometerRate = 50;
+        static constexpr uint8_t MagnetometerSize = 9;
+        static constexpr float MagnetometerScale = 0.15f;
+        // Data ready only shows in the reading of the I2C master that first sees a measurement, so the master reads
+        // the AK09916 about twice per measurement and the flag stays visible for at least one MPU update of 10ms
+        static constexpr uint8_t MagnetometerDelay = (1100 / (1 + MpuSampleRateDivider) + 2 * MagnetometerRate - 1) / (2 * MagnetometerRate) - 1;
+        static_assert(MagnetometerDelay < 32, "The I2C master delay has 5 bits");
+        // The external sensor registers are only read once a new measurement can be due, a quarter period before the
+        // next one is due after the last new one. A read before that could only return the same measurement.
+        static constexpr uint32_t MagnetometerPeriod = 1000000 / MagnetometerRate;
+        static constexpr uint32_t MagnetometerReadInterval = MagnetometerPeriod - MagnetometerPeriod / 4;
+        static constexpr float TemperatureScale = 1 / 333.87f;
+        static constexpr float TemperatureOffset = 21;
+
+        I2CQueue* Queue = nullptr;
         int8_t Controller;
-        bool Icm20948Present = false;
-        Adafruit_ICM20948 Icm20948;
+        int8_t InterruptPin = NC;
+        DeviceInit InitState;
         Tiny::Drivers::Input::TITinyConAccelerometerRanges AccelerationRange = Tiny::Drivers::Input::TITinyConAccelerometerRanges::G16;
         Tiny::Drivers::Input::TITinyConGyroscopeRanges GyroscopeRange = Tiny::Drivers::Input::TITinyConGyroscopeRanges::D2000;
+        // Per count, from the current ranges
+        float AccelerationScale = 9.80665f / 2048;
+        float AngularVelocityScale = 0.0174533f / 16.4f;
+
+        Sample Latest;
+        RawVector MagneticField = {};
+        uint8_t FifoCountRx[2] = {};
+        uint8_t FifoRx[MaxBatchSize * PacketSize] = {};
+        uint8_t MagnetometerRx[MagnetometerSize] = {};
+        uint32_t MagnetometerReadTime = 0;
+        uint32_t MagnetometerTime = 0;
+        uint16_t MagnetometerCount = 0;
+        bool NewMagneticField = false;
+        uint32_t StaleMagnetometerReads = 0;
+        uint32_t DrainTime = 0;
+        // Samples still in the FIFO behind the ones being read, for their timestamps
+        uint16_t Remaining = 0;
+        std::array<Sample, MaxBatchSize> Batch{};
+        uint8_t BatchSize = 0;
+        uint32_t Overflows = 0;
+        bool Failed = false;
+        // Samples drained and the edge of the first sample since the FIFO was reset. The first sample's edge is the
+        // smallest edge count less samples there ever were, an edge between the fill level read and its callback only
+        // makes one drain look one sample younger.
+        uint32_t Drained = 0;
+        uint32_t FirstEdge = 0;
+        bool EdgesSynced = false;
+        OrientationFilter Fusion;
+        // Learned while the sensor lies still and subtracted from every sample
+        GyroBias Bias;
+        Tiny::Math::TIVector3F AngularVelocityBias = {};
+        uint32_t BiasSaveTime = 0;
+
+        void UpdateInit();
+        /** Blocking, true if the sensor answers with its WHO_AM_I, which also means it is back from a reset */
+        bool Identify();
+        /** Wakes the sensor, starts its I2C master and resets the AK09916 */
+        void Wake();
+        /** Sets the magnetometer running, the ranges, the sample rate and starts sampling into the FIFO */
+        void Configure();
+        void SelectBank(uint8_t bank) { Queue->Write(GetAddress(), {RegisterBankSelect, static_cast<uint8_t>(bank << 4)}); }
+        /** Through slave 4, which does a single transfer and then disables itself */
+        void WriteMagnetometer(uint8_t reg, uint8_t value);
+        void WriteAccelerometerRange();
+        void WriteGyroscopeRange();
+        void ResetFifo();
+        static Tiny::Math::TIVector3F Scale(const RawVector& value, float scale) { return {value.X * scale, value.Y * scale, value.Z * scale}; }
+        /** The time of the data ready edge of the sample, or the fallback if that edge is no longer remembered */
+        uint32_t GetEdgeTime(uint32_t edge, uint32_t fallback) const;
+
+        static volatile uint32_t EdgeCount[MaxControllers];
+        static volatile uint32_t EdgeTimes[MaxControllers][EdgeDepth];
+        template <int8_t CController> static void OnDataReady()
+        {
+            const auto edge = EdgeCount[CController];
+            EdgeTimes[CController][edge & (EdgeDepth - 1)] = micros();
+            EdgeCount[CController] = edge + 1;
+        }
+        template <std::size_t... CControllers>
+        static constexpr std::array<void (*)(), sizeof...(CControllers)> MakeInterruptHandlers(std::index_sequence<CControllers...>)
+        { return {&OnDataReady<CControllers>...}; }
+        static const std::array<void (*)(), MaxControllers> InterruptHandlers;
+
+        static void OnFifoCount(void* context, const I2CTransaction& transaction);
+        static void OnFifoData(void* context, const I2CTransaction& transaction);
+        static void OnMagnetometer(void* context, const I2CTransaction& transaction);
     };
 }
\ No newline at end of file
@@ -0,0 +1,86 @@
+#include "MpuEncoder.h"
+
+#include <cstring>
+
+std::size_t TinyCon::MpuEncoder::Encode(const GamepadController& controller, Tiny::Collections::TIFixedSpan<uint8_t> data)
+{
+    auto* current = const_cast<uint8_t*>(data.data());
+    PendingDelta = false;
+    switch (controller.GetMpuFormat())
+    {
+        case Tiny::Drivers::Input::TITinyConMpuFormats::Raw:
+            return controller.MakeMpuRawBuffer(data);
+        case Tiny::Drivers::Input::TITinyConMpuFormats::Delta:
+            break;
+        default:
+            return controller.MakeMpuBuffer(data);
+    }
+    if (data.size() < 1) return 0;
+
+    PendingDelta = true;
+    PendingSize = controller.MakeMpuRawBuffer({Pending.data(), Tiny::Math::Min(Pending.size(), data.size() - 1)});
+    MpuSize = controller.GetMpuCount() ? PendingSize / controller.GetMpuCount() : 0;
+
+    // A delta that ends up no smaller than the keyframe would be, or one the host can't apply, goes out as a keyframe
+    PendingKeyframe = !HasBase || PendingSize != BaseSize || SinceKeyframe + 1 >= MpuKeyframeInterval;
+    auto size = PendingKeyframe ? 0 : EncodeDelta(current + 1, PendingSize);
+    PendingKeyframe |= !size;
+    if (PendingKeyframe)
+    {
+        memcpy(current + 1, Pending.data(), PendingSize);
+        size = PendingSize;
+    }
+    *current = (PendingKeyframe ? Keyframe : 0) | Sequence;
+    return size + 1;
+}
+
+std::size_t TinyCon::MpuEncoder::EncodeDelta(uint8_t* data, std::size_t size) const
+{
+    std::size_t length = 0;
+    for (uint16_t offset = 0; MpuSize && offset < PendingSize; offset += MpuSize)
+    {
+        // A range change rescales every value, the host needs the new header
+        if (Pending[offset] != Base[offset]) return 0;
+        for (uint16_t i = offset + 1; i + 1 < offset + MpuSize; i += 2)
+        {
+            const auto value = static_cast<uint16_t>(Pending[i] | Pending[i + 1] << 8);
+            const auto base = static_cast<uint16_t>(Base[i] | Base[i + 1] << 8);
+            // Zigzag, so small steps either way take few bits
+            const auto delta = static_cast<int16_t>(value - base);
+            auto zigzag = static_cast<uint16_t>(static_cast<uint16_t>(delta) << 1 ^ static_cast<uint16_t>(delta >> 15));
+            do
+            {
+                if (length >= size) return 0;
+                data[length++] = (zigzag & 0x7F) | (zigzag > 0x7F ? 0x80 : 0);
+                zigzag >>= 7;
+            }
+            while (zigzag);
+        }
+    }
+    return length;
+}
+
+void TinyCon::MpuEncoder::Sent()
+{
+    if (!PendingDelta)
+    {
+        // Whatever the host got before, the first Delta report after another format is a keyframe
+        HasBase = false;
+        return;
+    }
+
+    Base = Pending;
+    BaseSize = PendingSize;
+    HasBase = true;
+    Sequence = (Sequence + 1) & SequenceMask;
+    if (PendingKeyframe)
+    {
+        SinceKeyframe = 0;
+        ++KeyframeCount;
+    }
+    else
+    {
+        ++SinceKeyframe;
+        ++DeltaCount;
+    }
+}
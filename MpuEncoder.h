@@ -0,0 +1,58 @@
+#pragma once
+
+#include "Config.h"
+
+#include "GamepadController.h"
+
+#include "Core/Drivers/Input/TITinyConTypes.h"
+#include "Core/Utilities/Collections/TISpan.h"
+
+#include <Arduino.h>
+
+#include <array>
+#include <cstdint>
+
+namespace TinyCon
+{
+    /**
+     * Turns the MPU data of the snapshot into the wire format the host selected, see TITinyConMpuFormats. Delta
+     * reports only make sense against the report the host actually got before, so every transport has its own encoder
+     * and hands it every report that went out to Sent. Callers Encode, send, and only on success call Sent, the same
+     * as with the report filters.
+     */
+    class MpuEncoder
+    {
+    public:
+        static constexpr std::size_t MaxSize = GamepadController::Snapshot::MaxMpuRawData + 1;
+
+        /** As much as fits into the data, whole MPUs only for Raw and Delta */
+        std::size_t Encode(const GamepadController& controller, Tiny::Collections::TIFixedSpan<uint8_t> data);
+        void Sent();
+        /** The next Delta report is a keyframe, e.g. after a reconnect */
+        void Reset() { HasBase = false; }
+
+        [[nodiscard]] uint32_t GetKeyframeCount() const { return KeyframeCount; }
+        [[nodiscard]] uint32_t GetDeltaCount() const { return DeltaCount; }
+
+    private:
+        static constexpr uint8_t Keyframe = 0x80;
+        static constexpr uint8_t SequenceMask = 0x7F;
+
+        // The Raw data of the last report sent and of the one encoded since, which becomes the base once it was sent
+        std::array<uint8_t, MaxSize> Base{};
+        std::array<uint8_t, MaxSize> Pending{};
+        uint16_t BaseSize = 0;
+        uint16_t PendingSize = 0;
+        uint16_t MpuSize = 0;
+        bool HasBase = false;
+        bool PendingDelta = false;
+        bool PendingKeyframe = false;
+        uint8_t Sequence = 0;
+        uint16_t SinceKeyframe = 0;
+        uint32_t KeyframeCount = 0;
+        uint32_t DeltaCount = 0;
+
+        /** The delta frame after the header, 0 if it doesn't fit into the size or can't be encoded as a delta */
+        [[nodiscard]] std::size_t EncodeDelta(uint8_t* data, std::size_t size) const;
+    };
+}
@@ -0,0 +1,104 @@
+#include "OrientationFilter.h"
+
+#include <cmath>
+
+namespace
+{
+    /** Zero for a zero vector, the filter skips the correction then */
+    float InverseLength(float x, float y, float z)
+    {
+        const auto square = x * x + y * y + z * z;
+        return square > 0 ? 1 / sqrtf(square) : 0;
+    }
+}
+
+void TinyCon::OrientationFilter::Configure(float proportionalGain, float integralGain, float period)
+{
+    ProportionalGain = proportionalGain;
+    IntegralGain = integralGain;
+    Period = period;
+}
+
+void TinyCon::OrientationFilter::Level(float ax, float ay, float az)
+{
+    // The shortest rotation taking the measured gravity to Z, half-way between the two vectors, which needs no
+    // trigonometry. Upside down it is ambiguous, any half turn about a horizontal axis does.
+    if (az < -0.999f)
+    {
+        Orientation = {0, 1, 0, 0};
+        return;
+    }
+    const auto w = 1 + az;
+    const auto scale = 1 / sqrtf(w * w + ay * ay + ax * ax);
+    Orientation = {w * scale, ay * scale, -ax * scale, 0};
+}
+
+void TinyCon::OrientationFilter::Update(const Tiny::Math::TIVector3F& acceleration, const Tiny::Math::TIVector3F& angularVelocity, const Tiny::Math::TIVector3F& magneticField)
+{
+    auto gx = angularVelocity.X, gy = angularVelocity.Y, gz = angularVelocity.Z;
+    const auto accelerationScale = InverseLength(acceleration.X, acceleration.Y, acceleration.Z);
+    if (accelerationScale > 0)
+    {
+        const auto ax = acceleration.X * accelerationScale, ay = acceleration.Y * accelerationScale, az = acceleration.Z * accelerationScale;
+        if (!Initialized)
+        {
+            Level(ax, ay, az);
+            Initialized = true;
+            return;
+        }
+
+        auto& q = Orientation;
+        const auto q0q0 = q.W * q.W, q0q1 = q.W * q.X, q0q2 = q.W * q.Y, q0q3 = q.W * q.Z;
+        const auto q1q1 = q.X * q.X, q1q2 = q.X * q.Y, q1q3 = q.X * q.Z;
+        const auto q2q2 = q.Y * q.Y, q2q3 = q.Y * q.Z, q3q3 = q.Z * q.Z;
+
+        // Half the expected gravity direction in the sensor frame, the error is its cross product with the measured one
+        const auto vx = q1q3 - q0q2, vy = q0q1 + q2q3, vz = q0q0 - 0.5f + q3q3;
+        auto ex = ay * vz - az * vy, ey = az * vx - ax * vz, ez = ax * vy - ay * vx;
+
+        if (const auto magneticScale = InverseLength(magneticField.X, magneticField.Y, magneticField.Z); magneticScale > 0)
+        {
+            const auto mx = magneticField.X * magneticScale, my = magneticField.Y * magneticScale, mz = magneticField.Z * magneticScale;
+            // The field in the earth frame, turned into the horizontal plane so only the heading is corrected
+            const auto hx = 2 * (mx * (0.5f - q2q2 - q3q3) + my * (q1q2 - q0q3) + mz * (q1q3 + q0q2));
+            const auto hy = 2 * (mx * (q1q2 + q0q3) + my * (0.5f - q1q1 - q3q3) + mz * (q2q3 - q0q1));
+            const auto bx = sqrtf(hx * hx + hy * hy);
+            const auto bz = 2 * (mx * (q1q3 - q0q2) + my * (q2q3 + q0q1) + mz * (0.5f - q1q1 - q2q2));
+            const auto wx = bx * (0.5f - q2q2 - q3q3) + bz * (q1q3 - q0q2);
+            const auto wy = bx * (q1q2 - q0q3) + bz * (q0q1 + q2q3);
+            const auto wz = bx * (q0q2 + q1q3) + bz * (0.5f - q1q1 - q2q2);
+            ex += my * wz - mz * wy;
+            ey += mz * wx - mx * wz;
+            ez += mx * wy - my * wx;
+        }
+
+        if (IntegralGain > 0)
+        {
+            const auto integral = 2 * IntegralGain * Period;
+            Integral.X += integral * ex;
+            Integral.Y += integral * ey;
+            Integral.Z += integral * ez;
+            gx += Integral.X;
+            gy += Integral.Y;
+            gz += Integral.Z;
+        }
+        gx += 2 * ProportionalGain * ex;
+        gy += 2 * ProportionalGain * ey;
+        gz += 2 * ProportionalGain * ez;
+    }
+    else if (!Initialized) return;
+
+    // First order integration of the quaternion derivative, renormalized since it drifts off the unit sphere
+    const auto half = 0.5f * Period;
+    gx *= half;
+    gy *= half;
+    gz *= half;
+    auto& q = Orientation;
+    const auto w = q.W, x = q.X, y = q.Y;
+    q.W += -x * gx - y * gy - q.Z * gz;
+    q.X += w * gx + y * gz - q.Z * gy;
+    q.Y += w * gy - x * gz + q.Z * gx;
+    q.Z += w * gz + x * gy - y * gx;
+    const auto scale = 1 / sqrtf(q.W * q.W + q.X * q.X + q.Y * q.Y + q.Z * q.Z);
+    q = {q.W * scale, q.X * scale, q.Y * scale, q.Z * scale};
+}
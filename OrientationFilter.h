@@ -0,0 +1,46 @@
+#pragma once
+
+#include "Config.h"
+
+#include "Core/Math/TIQuaternion.h"
+#include "Core/Math/TIVector.h"
+
+#include <Arduino.h>
+
+#include <cstdint>
+
+namespace TinyCon
+{
+    /**
+     * Mahony filter, fuses accelerometer, gyroscope and optionally magnetometer samples into the orientation of the
+     * sensor as a unit quaternion, sensor to earth frame with Z up. The gyroscope is integrated and the error between
+     * the measured and the expected gravity and magnetic field directions is fed back through a PI controller, whose
+     * integral also tracks the gyroscope bias. All of it is single precision with one square root per vector, which the
+     * Cortex-M4F FPU does in hardware, and no trigonometry.
+     */
+    class OrientationFilter
+    {
+    public:
+        /** The gains are the proportional and integral feedback, the period is the time between samples in s */
+        void Configure(float proportionalGain, float integralGain, float period);
+        /** Forgets the orientation and the integral, the next sample levels the quaternion to its gravity vector */
+        void Reset() { Initialized = false; Integral = {}; Orientation = {1, 0, 0, 0}; }
+
+        /** Acceleration in any unit, angular velocity in rad/s, magnetic field in any unit or zero without */
+        void Update(const Tiny::Math::TIVector3F& acceleration, const Tiny::Math::TIVector3F& angularVelocity, const Tiny::Math::TIVector3F& magneticField);
+
+        [[nodiscard]] const Tiny::Math::TIQuaternionF& GetOrientation() const { return Orientation; }
+        /** The integral feedback added to the angular velocity, it settles at the negated gyroscope bias, in rad/s */
+        [[nodiscard]] const Tiny::Math::TIVector3F& GetIntegral() const { return Integral; }
+
+    private:
+        Tiny::Math::TIQuaternionF Orientation = {1, 0, 0, 0};
+        Tiny::Math::TIVector3F Integral = {};
+        float ProportionalGain = 1;
+        float IntegralGain = 0;
+        float Period = 0;
+        bool Initialized = false;
+
+        void Level(float ax, float ay, float az);
+    };
+}
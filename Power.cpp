@@ -30,6 +30,63 @@ void TinyCon::PowerController::Init()
     Update();
 }
 
+#if defined(NRF52840_XXAA)
+// The POWER interrupt belongs to the USB stack, PPI hands its VBUS events to EGU3 instead, which nothing else uses
+extern "C" void SWI3_EGU3_IRQHandler()
+{
+    NRF_EGU3->EVENTS_TRIGGERED[0] = 0;
+    NRF_EGU3->EVENTS_TRIGGERED[1] = 0;
+    TinyCon::WakeController::Signal(TinyCon::WakeController::WakePower);
+}
+#endif
+
+void TinyCon::PowerController::SetWakeOnVbus(bool enabled)
+{
+#if defined(NRF52840_XXAA)
+    // With the SoftDevice running the PPI is only reachable through it
+    uint8_t softDevice = 0;
+    sd_softdevice_is_enabled(&softDevice);
+    constexpr uint32_t channels = 1u << VbusPpiChannels[0] | 1u << VbusPpiChannels[1];
+    if (enabled)
+    {
+        NRF_EGU3->EVENTS_TRIGGERED[0] = 0;
+        NRF_EGU3->EVENTS_TRIGGERED[1] = 0;
+        NRF_EGU3->INTENSET = EGU_INTENSET_TRIGGERED0_Msk | EGU_INTENSET_TRIGGERED1_Msk;
+        NVIC_SetPriority(SWI3_EGU3_IRQn, VbusInterruptPriority);
+        NVIC_ClearPendingIRQ(SWI3_EGU3_IRQn);
+        NVIC_EnableIRQ(SWI3_EGU3_IRQn);
+        if (softDevice)
+        {
+            sd_ppi_channel_assign(VbusPpiChannels[0], &NRF_POWER->EVENTS_USBDETECTED, &NRF_EGU3->TASKS_TRIGGER[0]);
+            sd_ppi_channel_assign(VbusPpiChannels[1], &NRF_POWER->EVENTS_USBREMOVED, &NRF_EGU3->TASKS_TRIGGER[1]);
+            sd_ppi_channel_enable_set(channels);
+        }
+        else
+        {
+            NRF_PPI->CH[VbusPpiChannels[0]].EEP = reinterpret_cast<uint32_t>(&NRF_POWER->EVENTS_USBDETECTED);
+            NRF_PPI->CH[VbusPpiChannels[0]].TEP = reinterpret_cast<uint32_t>(&NRF_EGU3->TASKS_TRIGGER[0]);
+            NRF_PPI->CH[VbusPpiChannels[1]].EEP = reinterpret_cast<uint32_t>(&NRF_POWER->EVENTS_USBREMOVED);
+            NRF_PPI->CH[VbusPpiChannels[1]].TEP = reinterpret_cast<uint32_t>(&NRF_EGU3->TASKS_TRIGGER[1]);
+            NRF_PPI->CHENSET = channels;
+        }
+    }
+    else
+    {
+        if (softDevice) sd_ppi_channel_enable_clr(channels);
+        else NRF_PPI->CHENCLR = channels;
+        NVIC_DisableIRQ(SWI3_EGU3_IRQn);
+    }
+#else
+    if constexpr (USBAdcPin >= 0)
+    {
+        // Half of VBUS is only just above the input high level, which is marginal but good enough to wake up, the power
+        // task measures the actual voltage
+        if (enabled) attachInterrupt(digitalPinToInterrupt(USBAdcPin), OnVbusChanged, CHANGE);
+        else detachInterrupt(digitalPinToInterrupt(USBAdcPin));
+    }
+#endif
+}
+
 void TinyCon::PowerController::Update()
 {
     PowerSource = PowerSources::I2C;
@@ -2,6 +2,8 @@
 
 #include "Config.h"
 
+#include "Wake.h"
+
 #include <Arduino.h>
 #include <cstdint>
 #include <Wire.h>
@@ -9,6 +11,10 @@
 #if USE_LC709203
 #include <Adafruit_LC709203F.h>
 #endif
+#if defined(NRF52840_XXAA)
+#include <nrf_sdm.h>
+#include <nrf_soc.h>
+#endif
 
 namespace TinyCon
 {
@@ -25,12 +31,23 @@ namespace TinyCon
         static constexpr float BatteryPresentVoltage = 3.45f;
         static constexpr int8_t USBAdcPin = A7;
         static constexpr float USBPowerPresentVoltage = 4.6f;
+#if defined(NRF52840_XXAA)
+        // The SoftDevice keeps the last PPI channels for itself, the libraries start at the first ones
+        static constexpr uint8_t VbusPpiChannels[2] = {14, 15};
+        // Lowest application priority, which may call into FreeRTOS
+        static constexpr uint8_t VbusInterruptPriority = 7;
+#endif
 
     public:
         explicit PowerController(TwoWire& i2c) : I2C(i2c) {}
 
         void Init();
         void Update();
+        /**
+         * Wakes the firmware when VBUS comes or goes, only needed while suspended, the power task catches it otherwise. The
+         * nRF52840 uses the USBDETECTED and USBREMOVED events of its POWER peripheral, other boards the VBUS divider.
+         */
+        void SetWakeOnVbus(bool enabled);
 
         PowerSources PowerSource = PowerSources::USB;
         float USBPowerVoltage{};
@@ -44,6 +61,8 @@ namespace TinyCon
     private:
         TwoWire& I2C;
 
+        static void OnVbusChanged() { WakeController::Signal(WakeController::WakePower); }
+
 #if USE_LC709203
         bool LC709203FPresent = false;
         Adafruit_LC709203F LC709203F;
@@ -0,0 +1,72 @@
+#include "Profiler.h"
+
+#include "ReportFilter.h"
+
+void TinyCon::Profiler::Init()
+{
+#if defined(NRF52840_XXAA) || defined(NRF52832_XXAA)
+    CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+    DWT->CYCCNT = 0;
+    DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+#endif
+    Reset();
+}
+
+void TinyCon::Profiler::Add(Stages stage, uint32_t cycles)
+{
+    auto& statistics = Statistics[static_cast<uint8_t>(stage)];
+    ++statistics.Count;
+    statistics.Total += cycles;
+    if (cycles < statistics.Min) statistics.Min = cycles;
+    if (cycles > statistics.Max) statistics.Max = cycles;
+
+    int8_t bucket = 0;
+    for (auto limit = FirstBucketLimit * CyclesPerMicrosecond; bucket < BucketCount - 1 && cycles >= limit; limit <<= 2) ++bucket;
+    ++statistics.Buckets[bucket];
+}
+
+void TinyCon::Profiler::AddLatency(Stages stage, uint32_t timestamp, uint32_t& lastTimestamp)
+{
+    // Reports are sent at a fixed rate whether anything changed or not, only the first one carrying a sample counts
+    if (timestamp == lastTimestamp) return;
+    lastTimestamp = timestamp;
+    AddMicros(stage, micros() - timestamp);
+}
+
+#if !NO_BLE || !NO_USB
+void TinyCon::Profiler::AddReportFilter(GamepadReportFilter& filter)
+{
+    if (ReportFilterCount < MaxReportFilters) ReportFilters[ReportFilterCount++].Gamepad = &filter;
+}
+#endif
+
+void TinyCon::Profiler::AddReportFilter(MpuReportFilter& filter)
+{
+    if (ReportFilterCount < MaxReportFilters) ReportFilters[ReportFilterCount++].Mpu = &filter;
+}
+
+const TinyCon::ReportFilter& TinyCon::Profiler::GetReportFilter(int8_t index) const
+{
+#if !NO_BLE || !NO_USB
+    if (ReportFilters[index].Gamepad) return *ReportFilters[index].Gamepad;
+#endif
+    return *ReportFilters[index].Mpu;
+}
+
+void TinyCon::Profiler::ResetReportFilters()
+{
+    for (int8_t i = 0; i < ReportFilterCount; ++i)
+    {
+#if !NO_BLE || !NO_USB
+        if (ReportFilters[i].Gamepad) ReportFilters[i].Gamepad->ResetStatistics();
+#endif
+        if (ReportFilters[i].Mpu) ReportFilters[i].Mpu->ResetStatistics();
+    }
+}
+
+uint8_t TinyCon::Profiler::GetBucketShare(Stages stage, int8_t bucket) const
+{
+    const auto& statistics = GetStage(stage);
+    if (!statistics.Count) return 0;
+    return static_cast<uint64_t>(statistics.Buckets[bucket]) * 255 / statistics.Count;
+}
@@ -0,0 +1,110 @@
+#pragma once
+
+#include "Config.h"
+
+#include "Core/Drivers/Input/TITinyConTypes.h"
+
+#include <Arduino.h>
+
+#include <array>
+#include <cstdint>
+
+#if defined(NRF52840_XXAA) || defined(NRF52832_XXAA)
+#include <nordic/nrfx/mdk/nrf.h>
+#endif
+
+namespace TinyCon
+{
+    class ReportFilter;
+    class GamepadReportFilter;
+    class MpuReportFilter;
+
+    /**
+     * Per-stage timing statistics based on the DWT cycle counter, so stages much shorter than a millisecond can be
+     * measured without printing anything. Each stage keeps its minimum, maximum and mean duration plus a coarse
+     * histogram, which is what the Profile register window exposes. MCUs without a DWT and host builds fall back to
+     * micros(), which is good enough to check the bookkeeping. The transports add their report filters, whose
+     * counts and thresholds the window shows as well.
+     */
+    class Profiler
+    {
+    public:
+        using Stages = Tiny::Drivers::Input::TITinyConProfileStages;
+        static constexpr int8_t StageCount = static_cast<int8_t>(Stages::Count);
+        static constexpr int8_t BucketCount = 6;
+        // Each bucket is 4 times as wide as the previous one, starting at 64us, the last one takes everything above
+        static constexpr uint32_t FirstBucketLimit = 64;
+        // A gamepad and an MPU filter for each of USB and Bluetooth
+        static constexpr int8_t MaxReportFilters = 4;
+
+    #if defined(NRF52840_XXAA) || defined(NRF52832_XXAA)
+        static constexpr uint32_t CyclesPerMicrosecond = F_CPU / 1000000;
+        [[nodiscard]] static uint32_t GetCycles() { return DWT->CYCCNT; }
+    #else
+        static constexpr uint32_t CyclesPerMicrosecond = 1;
+        [[nodiscard]] static uint32_t GetCycles() { return micros(); }
+    #endif
+
+        struct Stage
+        {
+            uint32_t Count = 0;
+            uint32_t Min = UINT32_MAX;
+            uint32_t Max = 0;
+            uint64_t Total = 0;
+            std::array<uint32_t, BucketCount> Buckets{};
+        };
+
+        /** Measures from construction to destruction */
+        class Scope
+        {
+        public:
+            Scope(Profiler& profiler, Stages stage) : Owner(profiler), Stage(stage), Start(GetCycles()) {}
+            ~Scope() { Owner.Add(Stage, GetCycles() - Start); }
+            Scope(const Scope&) = delete;
+            Scope& operator=(const Scope&) = delete;
+
+        private:
+            Profiler& Owner;
+            Stages Stage;
+            uint32_t Start;
+        };
+
+        /** Enables the cycle counter, which is off after reset unless a debugger turned it on */
+        void Init();
+
+        [[nodiscard]] Scope Measure(Stages stage) { return {*this, stage}; }
+        void Add(Stages stage, uint32_t cycles);
+        void AddMicros(Stages stage, uint32_t us) { Add(stage, us < UINT32_MAX / CyclesPerMicrosecond ? us * CyclesPerMicrosecond : UINT32_MAX); }
+        /** Records the age of a sample taken at the given micros() timestamp, once per sample */
+        void AddLatency(Stages stage, uint32_t timestamp, uint32_t& lastTimestamp);
+        void Reset() { Statistics = {}; }
+
+        [[nodiscard]] const Stage& GetStage(Stages stage) const { return Statistics[static_cast<uint8_t>(stage)]; }
+        [[nodiscard]] uint32_t GetMin(Stages stage) const { const auto& s = GetStage(stage); return s.Count ? s.Min / CyclesPerMicrosecond : 0; }
+        [[nodiscard]] uint32_t GetMax(Stages stage) const { return GetStage(stage).Max / CyclesPerMicrosecond; }
+        [[nodiscard]] uint32_t GetMean(Stages stage) const { const auto& s = GetStage(stage); return s.Count ? s.Total / s.Count / CyclesPerMicrosecond : 0; }
+        /** Share of the samples in the given bucket, scaled to 0-255 */
+        [[nodiscard]] uint8_t GetBucketShare(Stages stage, int8_t bucket) const;
+
+        /** In the order they were added, filters beyond MaxReportFilters are ignored */
+        void AddReportFilter(GamepadReportFilter& filter);
+        void AddReportFilter(MpuReportFilter& filter);
+        [[nodiscard]] int8_t GetReportFilterCount() const { return ReportFilterCount; }
+        [[nodiscard]] const ReportFilter& GetReportFilter(int8_t index) const;
+        /** Null if the filter at the index is of the other kind */
+        [[nodiscard]] const GamepadReportFilter* GetGamepadFilter(int8_t index) const { return ReportFilters[index].Gamepad; }
+        [[nodiscard]] const MpuReportFilter* GetMpuFilter(int8_t index) const { return ReportFilters[index].Mpu; }
+        void ResetReportFilters();
+
+    private:
+        struct ReportFilterEntry
+        {
+            GamepadReportFilter* Gamepad = nullptr;
+            MpuReportFilter* Mpu = nullptr;
+        };
+
+        std::array<Stage, StageCount> Statistics{};
+        std::array<ReportFilterEntry, MaxReportFilters> ReportFilters{};
+        int8_t ReportFilterCount = 0;
+    };
+}
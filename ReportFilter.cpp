@@ -0,0 +1,62 @@
+#include "ReportFilter.h"
+
+#include "Utilities.h"
+
+#include <cmath>
+#include <cstring>
+
+#if !NO_BLE || !NO_USB
+bool TinyCon::GamepadReportFilter::IsDue(const hid_gamepad_report_t& report, uint32_t time)
+{
+    const auto changed = report.buttons != Last.buttons || report.hat != Last.hat ||
+                         IsAxisChanged(report.x, Last.x) || IsAxisChanged(report.y, Last.y) || IsAxisChanged(report.z, Last.z) ||
+                         IsAxisChanged(report.rx, Last.rx) || IsAxisChanged(report.ry, Last.ry) || IsAxisChanged(report.rz, Last.rz);
+    return ReportFilter::IsDue(changed, time);
+}
+
+bool TinyCon::GamepadReportFilter::IsAxisChanged(int8_t value, int8_t last) const
+{
+    if (value == last) return false;
+    // Releasing a stick or pushing it all the way has to arrive even if the last step was below the threshold
+    if (value == 0 || value >= INT8_MAX || value <= -INT8_MAX) return true;
+    return std::abs(value - last) > AxisThreshold;
+}
+#endif
+
+bool TinyCon::MpuReportFilter::IsDue(Tiny::Collections::TIFixedSpan<uint8_t> data, uint8_t fields, uint32_t time)
+{
+    const auto size = Tiny::Math::Min(data.size(), MaxSize);
+    auto changed = size != LastSize || fields != LastFields;
+
+    // Same order as MpuController::FillBuffer, each MPU repeats the enabled kinds. The timestamp and the magnetometer
+    // count are no halves and only matter along with the values, their bytes are skipped.
+    const struct { uint8_t Bit; uint8_t Count; uint8_t Skip; float Threshold; } layout[] =
+        {{1 << 3, 3, 0, Limits.Acceleration}, {1 << 2, 3, 0, Limits.AngularVelocity}, {1 << 1, 3, 0, Limits.Orientation},
+         {1 << 0, 1, 0, Limits.Temperature}, {1 << 4, 4, 0, Limits.Quaternion}, {1 << 5, 0, MpuController::TimestampSize, 0},
+         {1 << 6, 0, MpuController::MagnetometerCountSize, 0}};
+    const auto* current = data.data();
+    for (std::size_t offset = 0; !changed && (fields & 0x1F) && offset + 1 < size;)
+    {
+        for (const auto& kind : layout)
+        {
+            if (!(fields & kind.Bit)) continue;
+            for (uint8_t i = 0; i < kind.Count && offset + 1 < size; ++i, offset += 2)
+            {
+                const auto value = FloatFromHalf(current[offset] | current[offset + 1] << 8);
+                const auto last = FloatFromHalf(Last[offset] | Last[offset + 1] << 8);
+                changed |= std::fabs(value - last) > kind.Threshold;
+            }
+            offset += kind.Skip;
+        }
+    }
+
+    return ReportFilter::IsDue(changed, time);
+}
+
+void TinyCon::MpuReportFilter::Sent(Tiny::Collections::TIFixedSpan<uint8_t> data, uint8_t fields, uint32_t time)
+{
+    LastSize = Tiny::Math::Min(data.size(), MaxSize);
+    LastFields = fields;
+    memcpy(Last.data(), data.data(), LastSize);
+    MarkSent(time);
+}
@@ -0,0 +1,110 @@
+#pragma once
+
+#include "Config.h"
+
+#include "MpuController.h"
+
+#include "Core/Utilities/Collections/TISpan.h"
+
+#include <Arduino.h>
+#if !NO_BLE
+#include <bluefruit.h>
+#endif
+#if !NO_USB
+#include <Adafruit_TinyUSB.h>
+#endif
+
+#include <array>
+#include <cstdint>
+
+namespace TinyCon
+{
+    /**
+     * Decides whether a report is worth sending by comparing it with the last one that actually went out, so slow
+     * drift still adds up to a report eventually. Unchanged reports are held back until the keep-alive interval is up,
+     * which keeps the host's view fresh without spending airtime and battery on identical reports. Callers check with
+     * IsDue, send, and only on success hand the report to Sent.
+     */
+    class ReportFilter
+    {
+    public:
+        void SetKeepAlive(uint16_t keepAlive) { KeepAlive = keepAlive; }
+        [[nodiscard]] uint16_t GetKeepAlive() const { return KeepAlive; }
+        [[nodiscard]] uint32_t GetSentCount() const { return SentCount; }
+        [[nodiscard]] uint32_t GetSuppressedCount() const { return SuppressedCount; }
+        /** Forgets the last report, so the next one goes out whatever it contains, e.g. after a reconnect */
+        void Reset() { HasSent = false; }
+        void ResetStatistics() { SentCount = 0; SuppressedCount = 0; }
+
+    protected:
+        [[nodiscard]] bool IsDue(bool changed, uint32_t time)
+        {
+            if (changed || !HasSent || time - SentTime >= KeepAlive) return true;
+            ++SuppressedCount;
+            return false;
+        }
+        void MarkSent(uint32_t time)
+        {
+            HasSent = true;
+            SentTime = time;
+            ++SentCount;
+        }
+
+    private:
+        uint16_t KeepAlive = ReportKeepAlive;
+        bool HasSent = false;
+        uint32_t SentTime = 0;
+        uint32_t SentCount = 0;
+        uint32_t SuppressedCount = 0;
+    };
+
+#if !NO_BLE || !NO_USB
+    /** Buttons and the hat always count, an axis only once it moved by more than the threshold or came to rest or full scale */
+    class GamepadReportFilter : public ReportFilter
+    {
+    public:
+        void SetAxisThreshold(uint8_t threshold) { AxisThreshold = threshold; }
+        [[nodiscard]] uint8_t GetAxisThreshold() const { return AxisThreshold; }
+
+        [[nodiscard]] bool IsDue(const hid_gamepad_report_t& report, uint32_t time);
+        void Sent(const hid_gamepad_report_t& report, uint32_t time) { Last = report; MarkSent(time); }
+
+    private:
+        [[nodiscard]] bool IsAxisChanged(int8_t value, int8_t last) const;
+
+        hid_gamepad_report_t Last{};
+        uint8_t AxisThreshold = ReportAxisThreshold;
+    };
+#endif
+
+    /**
+     * Compares the MPU buffer value by value, laid out as GamepadController::MakeMpuBuffer fills it for the given
+     * MPUDataEnable bits, with a threshold per kind of value in the units of the MPU data.
+     */
+    class MpuReportFilter : public ReportFilter
+    {
+    public:
+        static constexpr std::size_t MaxSize = MpuController::MaxControllers * MpuController::MaxBufferSize;
+
+        struct Thresholds
+        {
+            float Acceleration = ReportAccelerationThreshold;
+            float AngularVelocity = ReportAngularVelocityThreshold;
+            float Orientation = ReportOrientationThreshold;
+            float Temperature = ReportTemperatureThreshold;
+            float Quaternion = ReportQuaternionThreshold;
+        };
+
+        void SetThresholds(const Thresholds& thresholds) { Limits = thresholds; }
+        [[nodiscard]] const Thresholds& GetThresholds() const { return Limits; }
+
+        [[nodiscard]] bool IsDue(Tiny::Collections::TIFixedSpan<uint8_t> data, uint8_t fields, uint32_t time);
+        void Sent(Tiny::Collections::TIFixedSpan<uint8_t> data, uint8_t fields, uint32_t time);
+
+    private:
+        Thresholds Limits;
+        std::array<uint8_t, MaxSize> Last{};
+        std::size_t LastSize = 0;
+        uint8_t LastFields = 0;
+    };
+}
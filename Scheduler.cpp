@@ -0,0 +1,85 @@
+#include "Scheduler.h"
+
+using LogScheduler = Tiny::TILogTarget<TinyCon::SchedulerLogLevel>;
+
+int8_t TinyCon::Scheduler::Add(const char* name, uint32_t period, uint32_t deadline, TaskCallback callback, bool active)
+{
+    if (TaskCount >= MaxTasks) return -1;
+
+    auto& task = Tasks[TaskCount];
+    task.Name = name;
+    task.Period = period;
+    task.Deadline = deadline;
+    task.Callback = std::move(callback);
+    task.NextRun = micros();
+    task.LastRun = millis();
+    task.Active = active;
+    return TaskCount++;
+}
+
+void TinyCon::Scheduler::SetActive(int8_t task, bool active)
+{
+    auto& current = Tasks[task];
+    if (active && !current.Active)
+    {
+        // Release immediately and start counting from now, so the first run doesn't see the inactive time
+        current.NextRun = micros();
+        current.LastRun = millis();
+    }
+    current.Active = active;
+}
+
+uint32_t TinyCon::Scheduler::Update()
+{
+    for (int8_t i = 0; i < TaskCount; ++i)
+    {
+        auto& task = Tasks[i];
+        if (!task.Active) continue;
+
+        const auto start = micros();
+        if (!task.Triggered && static_cast<int32_t>(start - task.NextRun) < 0) continue;
+
+        const auto release = task.Triggered ? start : task.NextRun;
+        const auto time = millis();
+        const auto deltaTime = time - task.LastRun;
+        task.LastRun = time;
+        task.Triggered = false;
+
+        task.Callback(deltaTime);
+
+        const auto end = micros();
+        task.MaxDuration = Tiny::Math::Max(task.MaxDuration, end - start);
+        ++task.Runs;
+        if (static_cast<int32_t>(end - (release + task.Deadline)) > 0)
+        {
+            ++task.Overruns;
+            LogScheduler::Debug("Overrun: ", task.Name, ", ", end - release, "us", Tiny::TIEndl);
+        }
+
+        task.NextRun += task.Period;
+        // Drop releases we missed, catching up would only starve the tasks after this one
+        if (static_cast<int32_t>(end - task.NextRun) >= 0) task.NextRun = end + task.Period;
+    }
+
+    const auto now = micros();
+    uint32_t wait = UINT32_MAX;
+    for (int8_t i = 0; i < TaskCount; ++i)
+    {
+        const auto& task = Tasks[i];
+        if (!task.Active) continue;
+        if (task.Triggered || static_cast<int32_t>(task.NextRun - now) <= 0) return 0;
+        wait = Tiny::Math::Min(wait, task.NextRun - now);
+    }
+
+    return wait;
+}
+
+void TinyCon::Scheduler::ResetStatistics()
+{
+    for (auto& task : Tasks)
+    {
+        task.Runs = 0;
+        task.Overruns = 0;
+        task.MaxDuration = 0;
+    }
+}
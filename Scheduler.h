@@ -0,0 +1,62 @@
+#pragma once
+
+#include "Config.h"
+
+#include "Core/Math/TIMath.h"
+
+#include <Arduino.h>
+
+#include <array>
+#include <cstdint>
+#include <functional>
+
+namespace TinyCon
+{
+    /**
+     * Simple cooperative multi-rate scheduler. Each task has its own period and deadline in microseconds and is
+     * released whenever its period elapsed, tasks are run in the order they were added, so the hot input path
+     * should be added first. A task finishing later than its release time plus its deadline counts as an overrun.
+     * Tasks that fall behind by more than one period are re-synchronized instead of being run back-to-back.
+     */
+    class Scheduler
+    {
+    public:
+        static constexpr int8_t MaxTasks = 12;
+        using TaskCallback = std::function<void(uint32_t)>;
+
+        struct Task
+        {
+            const char* Name = nullptr;
+            uint32_t Period = 0;
+            uint32_t Deadline = 0;
+            TaskCallback Callback;
+
+            bool Active = false;
+            bool Triggered = false;
+            uint32_t NextRun = 0;
+            uint32_t LastRun = 0;
+
+            uint32_t Runs = 0;
+            uint32_t Overruns = 0;
+            uint32_t MaxDuration = 0;
+        };
+
+        /** Add a task, the callback receives the time since its last run in ms, returns the task index or -1. */
+        int8_t Add(const char* name, uint32_t period, uint32_t deadline, TaskCallback callback, bool active = true);
+        void SetActive(int8_t task, bool active);
+        [[nodiscard]] bool IsActive(int8_t task) const { return Tasks[task].Active; }
+        /** Release the task on the next update, independent of its period. */
+        void Trigger(int8_t task) { Tasks[task].Triggered = true; }
+
+        /** Run all released tasks, returns the time in us until the next task is due. */
+        uint32_t Update();
+
+        [[nodiscard]] int8_t GetTaskCount() const { return TaskCount; }
+        [[nodiscard]] const Task& GetTask(int8_t task) const { return Tasks[task]; }
+        void ResetStatistics();
+
+    private:
+        std::array<Task, MaxTasks> Tasks{};
+        int8_t TaskCount = 0;
+    };
+}
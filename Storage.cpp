@@ -0,0 +1,58 @@
+#include "Storage.h"
+
+#if USE_LITTLEFS
+#include <Adafruit_LittleFS.h>
+#include <InternalFileSystem.h>
+
+using namespace Adafruit_LittleFS_Namespace;
+#endif
+
+using LogStorage = Tiny::TILogTarget<TinyCon::StorageLogLevel>;
+
+bool TinyCon::Storage::Begin()
+{
+#if USE_LITTLEFS
+    static bool started = false;
+    if (!started) started = InternalFS.begin();
+    return started;
+#else
+    return false;
+#endif
+}
+
+bool TinyCon::Storage::Load(const char* path, uint32_t magic, void* data, std::size_t size)
+{
+#if USE_LITTLEFS
+    if (!Begin()) return false;
+    File file(InternalFS);
+    if (!file.open(path, FILE_O_READ)) return false;
+
+    uint32_t storedMagic = 0;
+    const auto success = file.size() == sizeof(storedMagic) + size && file.read(&storedMagic, sizeof(storedMagic)) == sizeof(storedMagic) &&
+                         storedMagic == magic && file.read(data, size) == static_cast<int>(size);
+    file.close();
+    if (!success) LogStorage::Warning("Storage: Ignoring ", path, Tiny::TIEndl);
+    return success;
+#else
+    return false;
+#endif
+}
+
+bool TinyCon::Storage::Save(const char* path, uint32_t magic, const void* data, std::size_t size)
+{
+#if USE_LITTLEFS
+    if (!Begin()) return false;
+    // Writes append on LittleFS, start from an empty file
+    InternalFS.remove(path);
+    File file(InternalFS);
+    if (!file.open(path, FILE_O_WRITE)) return false;
+
+    const auto success = file.write(reinterpret_cast<const uint8_t*>(&magic), sizeof(magic)) == sizeof(magic) &&
+                         file.write(static_cast<const uint8_t*>(data), size) == size;
+    file.close();
+    if (!success) LogStorage::Error("Storage: Writing ", path, " failed", Tiny::TIEndl);
+    return success;
+#else
+    return false;
+#endif
+}
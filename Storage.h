@@ -0,0 +1,26 @@
+#pragma once
+
+#include "Config.h"
+
+#include <Arduino.h>
+
+#include <cstddef>
+#include <cstdint>
+
+namespace TinyCon
+{
+    /**
+     * Small blobs persisted in the internal flash, each in its own file. The blob starts with a caller-chosen magic,
+     * so a file from an older layout is ignored instead of being misread. Without LittleFS, nothing is persisted and
+     * every load fails, callers fall back to their defaults.
+     */
+    class Storage
+    {
+    public:
+        static bool Load(const char* path, uint32_t magic, void* data, std::size_t size);
+        static bool Save(const char* path, uint32_t magic, const void* data, std::size_t size);
+
+    private:
+        static bool Begin();
+    };
+}
@@ -101,24 +101,17 @@ void setup()
     Watchdog.enable(2000);
 }
 
-constexpr auto UpdateFrequency = 1000 / 100;
-uint32_t LastTime = 0;
+// Upper bound for a single sleep, keeps us well within the watchdog timeout
+constexpr uint32_t MaxSleepTime = 1000;
 void loop()
 {
-    auto time = millis();
-    auto deltaTime = time - LastTime;
-    LastTime = time;
-
     UpdateHapticTest();
-    Controller.Update(deltaTime);
+    const auto wait = Controller.Update();
 
     Watchdog.reset();
-    if (Controller.IsSuspended()) Watchdog.sleep(500);
-    else
-    {
-        const auto updateTime = millis() - LastTime;
-        if (updateTime < UpdateFrequency) Watchdog.sleep(UpdateFrequency - updateTime);
-    }
+    // The scheduler tells us when the next task is due, anything below 1ms is not worth going to sleep for. Buttons,
+    // VBUS and the I2C slave end the sleep early, so this is also all the waiting we do while suspended.
+    if (wait >= 1000) Controller.Sleep(Tiny::Math::Min(wait / 1000, MaxSleepTime));
 }
 
 #ifndef HI_MAKEFILE_BUILDSYSTEM
@@ -2,8 +2,12 @@
 
 using LogState = Tiny::TILogTarget<TinyCon::StateLogLevel>;
 
-void TinyCon::TinyController::Init(int8_t hatOffset, const std::array<int8_t, MaxNativeAdcPinCount>& axisPins, const std::array<int8_t, MaxNativeGpioPinCount>& buttonPins, ActiveState activeState)
+void TinyCon::TinyController::Init(int8_t hatOffset, std::initializer_list<int8_t> axisPins, std::initializer_list<int8_t> buttonPins, ActiveState activeState)
 {
+    Profile.Init();
+    Wake.Init();
+    // Stored bus profiles skip the clock calibration of devices that were already seen
+    I2C0Queue.GetProfiles().Load();
     Controller.Init(hatOffset, axisPins, buttonPins, activeState);
     Power.Init();
     Processor.Init();
@@ -22,30 +26,113 @@ void TinyCon::TinyController::Init(int8_t hatOffset, const std::array<int8_t, Ma
     Bluetooth.SetActive(Power.PowerSource == PowerSources::Battery || !USBControl.IsActive());
 #endif
     Indicators.Init();
+
+    // Ordered by priority, the hot input path goes first so it never waits for the housekeeping tasks
+    Tasks.Add("MPU", MpuPeriod, MpuPeriod, [this](uint32_t)
+        {
+            const auto scope = Profile.Measure(Profiler::Stages::Mpu);
+            Controller.UpdateMpus();
+        });
+    Tasks.Add("Input", InputPeriod, InputPeriod, [this](uint32_t) { Controller.UpdateInputs(); });
+    // Haptics are event-driven, only active while there are commands queued
+    Tasks.Add("Haptic", HapticPeriod, HapticPeriod, [this](uint32_t deltaTime)
+        {
+            const auto scope = Profile.Measure(Profiler::Stages::Haptic);
+            Controller.UpdateHaptics(deltaTime);
+        }, false);
+    // Added after the input task, so a sample taken in the same update is part of this report
+    Tasks.Add("Report", ReportPeriod, ReportPeriod, [this](uint32_t deltaTime)
+        {
+            Controller.DecimateInputs();
+            UpdateSelectButton(deltaTime, Controller.GetButton(BluetoothStartButtonIndex));
+            UpdateReports(deltaTime);
+        });
+    Tasks.Add("Suspended", SuspendedPeriod, SuspendedPeriod, [this](uint32_t deltaTime)
+        {
+            const auto selectButton = Controller.GetUpdatedButton(BluetoothStartButtonIndex);
+            UpdateSelectButton(deltaTime, selectButton);
+            // The next press wakes us through the INT line, so only keep polling to time the hold
+            if (!selectButton && Controller.CanWakeOnButton(BluetoothStartButtonIndex)) Tasks.SetActive(TaskSuspended, false);
+        }, false);
+    Tasks.Add("Devices", DevicePeriod, DevicePeriod, [this](uint32_t)
+        {
+            Discovery.Update();
+            Controller.UpdateDevices();
+        });
+    Tasks.Add("Power", PowerPeriod, PowerPeriod, [this](uint32_t) { UpdatePower(); });
+    Tasks.Add("Indicators", IndicatorPeriod, IndicatorPeriod, [this](uint32_t deltaTime) { UpdateIndicators(deltaTime); });
+    Tasks.Add("Display", DisplayPeriod, DisplayPeriod, [this](uint32_t) { UpdateDisplay(); });
 }
 
-void TinyCon::TinyController::Update(int32_t deltaTime)
+uint32_t TinyCon::TinyController::Update()
 {
-    bool i2cNeedsUpdate = Power.PowerSource == PowerSources::I2C || (!Processor.GetUSBEnabled() && !Processor.GetBLEEnabled());
-    bool bluetoothWasConnected = Bluetooth.IsConnected();
-    bool bluetoothNeedsUpdate = !i2cNeedsUpdate && Bluetooth.IsActive();
-    bool usbNeedsUpdate = !i2cNeedsUpdate && !Bluetooth.IsConnected() && USBControl.IsActive();
-    if (i2cNeedsUpdate || bluetoothNeedsUpdate || usbNeedsUpdate)
+    UpdateState();
+    I2C.Update();
+    const auto wait = Tasks.Update();
+
+    // Queued transactions only advance when polled, so don't go to sleep while there are some left
+    I2C0Queue.Update();
+    return I2C0Queue.IsIdle() ? wait : 0;
+}
+
+void TinyCon::TinyController::UpdateState()
+{
+    const auto wakeSources = Wake.TakeSources();
+    // VBUS came or went, don't wait for the next power period to switch over
+    if (wakeSources & WakeController::WakePower) Tasks.Trigger(TaskPower);
+
+    I2CNeedsUpdate = Power.PowerSource == PowerSources::I2C || (!Processor.GetUSBEnabled() && !Processor.GetBLEEnabled());
+    BluetoothNeedsUpdate = !I2CNeedsUpdate && Bluetooth.IsActive();
+    USBNeedsUpdate = !I2CNeedsUpdate && !Bluetooth.IsConnected() && USBControl.IsActive();
+
+    const auto suspended = !I2CNeedsUpdate && !BluetoothNeedsUpdate && !USBNeedsUpdate;
+    if (suspended != Suspended)
     {
-        LogState::Info("State: Updating", Tiny::TIEndl);
-        Controller.Update(deltaTime);
+        if (suspended)
+        {
+            LogState::Info("State: Suspended", Tiny::TIEndl);
+            Indicators.Disable();
+        }
+        else LogState::Info("State: Updating", Tiny::TIEndl);
+
+        Suspended = suspended;
+        Power.SetWakeOnVbus(Suspended);
+        Tasks.SetActive(TaskMpu, !Suspended);
+        Tasks.SetActive(TaskInput, !Suspended);
+        Tasks.SetActive(TaskReport, !Suspended);
+        Tasks.SetActive(TaskDevices, !Suspended);
+        Tasks.SetActive(TaskIndicators, !Suspended);
+        Tasks.SetActive(TaskDisplay, !Suspended);
+        Tasks.SetActive(TaskSuspended, Suspended);
+    }
+
+    if (Suspended && (wakeSources & WakeController::WakeInput)) Tasks.SetActive(TaskSuspended, true);
+    Tasks.SetActive(TaskHaptic, !Suspended && Controller.HasHapticCommands());
+    // A Seesaw signalled a button change, read it right away instead of waiting for the next input period
+    if (!Suspended && Controller.HasPendingInput()) Tasks.Trigger(TaskInput);
+}
+
+void TinyCon::TinyController::UpdateReports(int32_t deltaTime)
+{
+    {
+        const auto scope = Profile.Measure(Profiler::Stages::Command);
         Processor.Update();
-        if (bluetoothNeedsUpdate) Bluetooth.Update(deltaTime);
-        if (usbNeedsUpdate) USBControl.Update();
-        UpdateSelectButton(deltaTime, Controller.GetButton(BluetoothStartButtonIndex));
-        Suspended = false;
     }
-    else
+    if (BluetoothNeedsUpdate)
     {
-        LogState::Info("State: Suspended", Tiny::TIEndl);
-        UpdateSelectButton(deltaTime, Controller.GetUpdatedButton(BluetoothStartButtonIndex));
-        Suspended = true;
+        const auto scope = Profile.Measure(Profiler::Stages::BleReport);
+        Bluetooth.Update(deltaTime);
     }
+    if (USBNeedsUpdate)
+    {
+        const auto scope = Profile.Measure(Profiler::Stages::UsbReport);
+        USBControl.Update();
+    }
+}
+
+void TinyCon::TinyController::UpdatePower()
+{
+    Controller.LogBuses();
 
     bool powerWasUsb = Power.PowerSource == PowerSources::USB;
     bool powerWasI2c = Power.PowerSource == PowerSources::I2C;
@@ -81,7 +168,7 @@ void TinyCon::TinyController::Update(int32_t deltaTime)
             USBControl.SetActive(true);
             Bluetooth.SetActive(false);
         }
-        else if (bluetoothWasConnected && !Bluetooth.IsConnected())
+        else if (BluetoothWasConnected && !Bluetooth.IsConnected())
         {
             LogState::Debug("Forced Bluetooth on USB disconnect, enabling USB, stopping auto-advertising", Tiny::TIEndl);
             USBControl.SetActive(true);
@@ -95,7 +182,7 @@ void TinyCon::TinyController::Update(int32_t deltaTime)
         Bluetooth.SetActive(true);
     }
 
-    UpdateIndicators(deltaTime);
+    BluetoothWasConnected = Bluetooth.IsConnected();
 }
 
 void TinyCon::TinyController::UpdateSelectButton(int32_t deltaTime, bool selectButton)
@@ -114,56 +201,59 @@ void TinyCon::TinyController::UpdateSelectButton(int32_t deltaTime, bool selectB
 
 void TinyCon::TinyController::UpdateIndicators(int32_t deltaTime)
 {
-    if (Suspended) Indicators.Disable();
-    else
-    {
-        if (Bluetooth.IsAdvertising()) Indicators.SetBlue(IndicatorController::LedEffects::Fade);
-        else if (Bluetooth.IsConnected()) Indicators.SetBlue(IndicatorController::LedEffects::Pulse);
-        else Indicators.SetBlue(IndicatorController::LedEffects::Off);
+    if (Bluetooth.IsAdvertising()) Indicators.SetBlue(IndicatorController::LedEffects::Fade);
+    else if (Bluetooth.IsConnected()) Indicators.SetBlue(IndicatorController::LedEffects::Pulse);
+    else Indicators.SetBlue(IndicatorController::LedEffects::Off);
 
-        if (Power.PowerSource == PowerSources::I2C) Indicators.SetRed(IndicatorController::LedEffects::Pulse);
-        else if (Bluetooth.IsConnected() || Power.PowerSource != PowerSources::USB) Indicators.SetRed(IndicatorController::LedEffects::Off);
-        else if (USBControl.IsConnected()) Indicators.SetRed(IndicatorController::LedEffects::On);
-        else Indicators.SetRed(IndicatorController::LedEffects::Fade);
+    if (Power.PowerSource == PowerSources::I2C) Indicators.SetRed(IndicatorController::LedEffects::Pulse);
+    else if (Bluetooth.IsConnected() || Power.PowerSource != PowerSources::USB) Indicators.SetRed(IndicatorController::LedEffects::Off);
+    else if (USBControl.IsConnected()) Indicators.SetRed(IndicatorController::LedEffects::On);
+    else Indicators.SetRed(IndicatorController::LedEffects::Fade);
 
 #if USE_NEOPIXEL
-        if (Power.PowerSource == PowerSources::USB)
-        {
-            if (Power.Battery.Voltage < 4.1f)
-            {
-                Indicators.SetRgbRed(IndicatorController::LedEffects::Pulse);
-                Indicators.SetRgbGreen(IndicatorController::LedEffects::Off);
-            }
-            else
-            {
-                Indicators.SetRgbRed(IndicatorController::LedEffects::Off);
-                Indicators.SetRgbGreen(IndicatorController::LedEffects::On);
-            }
-
-            Indicators.SetRgbBlue(IndicatorController::LedEffects::Off);
-        }
-        else if (Power.PowerSource == PowerSources::Battery)
+    if (Power.PowerSource == PowerSources::USB)
+    {
+        if (Power.Battery.Voltage < 4.1f)
         {
-            if (Power.Battery.Percentage < 0.2f) Indicators.SetRgbRed(IndicatorController::LedEffects::Pulse);
-            else Indicators.SetRgbRed(IndicatorController::LedEffects::Off);
+            Indicators.SetRgbRed(IndicatorController::LedEffects::Pulse);
             Indicators.SetRgbGreen(IndicatorController::LedEffects::Off);
-            Indicators.SetRgbBlue(IndicatorController::LedEffects::Fixed, 127 * Power.Battery.Percentage);
         }
         else
         {
             Indicators.SetRgbRed(IndicatorController::LedEffects::Off);
-            Indicators.SetRgbGreen(IndicatorController::LedEffects::Off);
-            Indicators.SetRgbBlue(IndicatorController::LedEffects::Off);
+            Indicators.SetRgbGreen(IndicatorController::LedEffects::On);
         }
-#endif
 
-        char mode = 'D';
-        if (Power.PowerSource == PowerSources::I2C) mode = 'I';
-        else if (Bluetooth.IsConnected()) mode = 'B';
-        else if (Bluetooth.IsAdvertising())
-            if (USBControl.IsConnected()) mode = 'F';
-            else mode = 'A';
-        else if (USBControl.IsConnected()) mode = 'U';
-        Indicators.Update(deltaTime, mode);
+        Indicators.SetRgbBlue(IndicatorController::LedEffects::Off);
     }
+    else if (Power.PowerSource == PowerSources::Battery)
+    {
+        if (Power.Battery.Percentage < 0.2f) Indicators.SetRgbRed(IndicatorController::LedEffects::Pulse);
+        else Indicators.SetRgbRed(IndicatorController::LedEffects::Off);
+        Indicators.SetRgbGreen(IndicatorController::LedEffects::Off);
+        Indicators.SetRgbBlue(IndicatorController::LedEffects::Fixed, 127 * Power.Battery.Percentage);
+    }
+    else
+    {
+        Indicators.SetRgbRed(IndicatorController::LedEffects::Off);
+        Indicators.SetRgbGreen(IndicatorController::LedEffects::Off);
+        Indicators.SetRgbBlue(IndicatorController::LedEffects::Off);
+    }
+#endif
+
+    Indicators.Update(deltaTime);
+}
+
+void TinyCon::TinyController::UpdateDisplay()
+{
+    char mode = 'D';
+    if (Power.PowerSource == PowerSources::I2C) mode = 'I';
+    else if (Bluetooth.IsConnected()) mode = 'B';
+    else if (Bluetooth.IsAdvertising())
+        if (USBControl.IsConnected()) mode = 'F';
+        else mode = 'A';
+    else if (USBControl.IsConnected()) mode = 'U';
+
+    const auto scope = Profile.Measure(Profiler::Stages::Display);
+    Indicators.UpdateDisplay(mode);
 }
@@ -6,9 +6,13 @@
 #include "CommandProcessor.h"
 #include "GamepadController.h"
 #include "I2C.h"
+#include "I2CQueue.h"
 #include "Indicators.h"
 #include "Power.h"
+#include "Profiler.h"
+#include "Scheduler.h"
 #include "USB.h"
+#include "Wake.h"
 
 #include <Arduino.h>
 #include <Wire.h>
@@ -21,20 +25,48 @@ namespace TinyCon
         static constexpr auto BluetoothStartButtonIndex = 4;
         static constexpr auto BluetoothStartButtonTime = 5 * 1000;
 
+        // Task periods in us, deadlines are the same as the periods unless noted otherwise
+        enum TaskIds : int8_t { TaskMpu = 0, TaskInput, TaskHaptic, TaskReport, TaskSuspended, TaskDevices, TaskPower, TaskIndicators, TaskDisplay };
+        // The IMUs sample into their FIFOs on their own, this only decides how many samples each update drains
+        static constexpr uint32_t MpuPeriod = 1000000 / 100;
+        static constexpr uint32_t ReportPeriod = 1000000 / 100;
+        // Inputs are oversampled, every report decimates the samples taken since the one before
+        static_assert(InputOversampling > 0, "Inputs are sampled at least once per report");
+        static constexpr uint32_t InputPeriod = ReportPeriod / InputOversampling;
+        static constexpr uint32_t HapticPeriod = 1000000 / 100;
+        // While suspended, the select button is only polled while held, or all the time if its pad has no INT line
+        static constexpr uint32_t SuspendedPeriod = 500000;
+        static constexpr uint32_t DevicePeriod = 1000000 / 50;
+        static constexpr uint32_t PowerPeriod = 1000000;
+        static constexpr uint32_t IndicatorPeriod = 1000000 / 50;
+        static constexpr uint32_t DisplayPeriod = 1000000 / 15;
+
     public:
         TinyController(TwoWire& slaveI2C, TwoWire& masterI2C0, SoftWire& masterI2C1)
-            : Controller(masterI2C0, masterI2C1), Power(masterI2C0), Processor(Controller, Power),
-              USBControl(Controller, Processor), Bluetooth(Controller, Processor),
-              Indicators(masterI2C0, Controller, Power), I2C(slaveI2C, Processor) {}
+            : Wake(Profile), I2C0Queue(masterI2C0), Discovery(I2C0Queue), Controller(masterI2C0, I2C0Queue, Discovery, masterI2C1, Profile), Power(masterI2C0),
+              Processor(Controller, Power, Profile, Tasks),
+              USBControl(Controller, Processor, Profile), Bluetooth(Controller, Processor, Profile),
+              Indicators(masterI2C0, I2C0Queue, Discovery, Controller, Power), I2C(slaveI2C, Processor, Profile) {}
 
-        void Init(int8_t hatOffset = -1, const std::array<int8_t, MaxNativeAdcPinCount>& axisPins = {NC}, const std::array<int8_t, MaxNativeGpioPinCount>& buttonPins = {NC}, ActiveState activeState = ActiveState::Low);
-        void Update(int32_t deltaTime);
+        void Init(int8_t hatOffset = -1, std::initializer_list<int8_t> axisPins = {}, std::initializer_list<int8_t> buttonPins = {}, ActiveState activeState = ActiveState::Low);
+        /** Runs all due tasks and returns the time in us until the next one is due */
+        uint32_t Update();
+        /** Sleeps for up to the given time in ms, or until a button, VBUS or the I2C slave wakes us */
+        void Sleep(uint32_t time) { Wake.Sleep(time); }
 
         void AddHapticCommand(Tiny::Collections::TIFixedSpan<uint8_t> data) { Controller.AddHapticCommand(data); }
 
         [[nodiscard]] bool IsSuspended() const { return Suspended; }
+        [[nodiscard]] const Scheduler& GetScheduler() const { return Tasks; }
+        [[nodiscard]] const Profiler& GetProfiler() const { return Profile; }
 
     private:
+        // Declared first, everything else may be measured during construction
+        Profiler Profile;
+        Scheduler Tasks;
+        WakeController Wake;
+        I2CQueue I2C0Queue;
+        DiscoveryService Discovery;
         GamepadController Controller;
         PowerController Power;
         CommandProcessor Processor;
@@ -45,8 +77,16 @@ namespace TinyCon
 
         int32_t BluetoothStartPressedTimeout = BluetoothStartButtonTime;
         bool Suspended = false;
+        bool I2CNeedsUpdate = false;
+        bool BluetoothNeedsUpdate = false;
+        bool USBNeedsUpdate = false;
+        bool BluetoothWasConnected = false;
 
+        void UpdateState();
+        void UpdateReports(int32_t deltaTime);
+        void UpdatePower();
         void UpdateIndicators(int32_t deltaTime);
+        void UpdateDisplay();
 
         void UpdateSelectButton(int32_t deltaTime, bool selectButton);
     };
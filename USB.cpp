@@ -16,6 +16,8 @@ std::function<uint16_t(uint8_t, hid_report_type_t, uint8_t*, uint16_t)> TinyCon:
 void TinyCon::USBController::Init()
 {
     LogUsb::Info("USB Init", Tiny::TIEndl);
+    Profile.AddReportFilter(GamepadFilter);
+    Profile.AddReportFilter(MpuFilter);
     Gamepad.setPollInterval(10);
     Gamepad.setStringDescriptor("Game Controller");
     Gamepad.setReportDescriptor(HidDescriptor, sizeof(HidDescriptor));
@@ -23,7 +25,18 @@ void TinyCon::USBController::Init()
     ReportReceived = [this](uint8_t reportId, hid_report_type_t report, const uint8_t* data, uint16_t length)
         {
             if (Processor.GetUSBEnabled() && reportId == USBController::ReportCommand && length >= 1)
+            {
+                RegisterAddress = data[0];
                 Processor.ProcessCommand({data, length});
+            }
+        };
+    // Reading the command report returns the registers from the last written address on, the same as on I2C
+    ReportRequested = [this](uint8_t reportId, hid_report_type_t report, uint8_t* data, uint16_t length) -> uint16_t
+        {
+            if (!Processor.GetUSBEnabled() || reportId != USBController::ReportCommand || report != HID_REPORT_TYPE_INPUT) return 0;
+            const auto size = Tiny::Math::Min(Tiny::Math::Min(length, CommandReportSize), static_cast<uint16_t>(Processor.Registers.size() - RegisterAddress));
+            memcpy(data, Processor.Registers.data() + RegisterAddress, size);
+            return size;
         };
     Gamepad.setReportCallback(UsbHidReportRequested, UsbHidReportReceived);
     Gamepad.begin();
@@ -39,17 +52,47 @@ void TinyCon::USBController::Update()
 
         Active = false;
         Connected = false;
+        GamepadFilter.Reset();
+        MpuFilter.Reset();
+        MpuEncoding.Reset();
     }
     else if ((Connected = TinyUSBDevice.mounted() && Gamepad.ready()))
     {
+        // Only changed reports go out, which also leaves the endpoint free for the MPU report more often
         LogUsb::Debug("Controller");
-        auto report = Controller.MakeHidReport();
-        Gamepad.sendReport(ReportGamepad, &report, sizeof(report));
+        const auto time = millis();
+        uint32_t timestamp;
+        auto report = Controller.MakeHidReport(&timestamp);
+        if (GamepadFilter.IsDue(report, time) && Gamepad.sendReport(ReportGamepad, &report, sizeof(report)))
+        {
+            GamepadFilter.Sent(report, time);
+            Profile.AddLatency(Profiler::Stages::UsbInputLatency, timestamp, LastInputTimestamp);
+        }
 
         LogUsb::Debug(", MPU");
         uint8_t data[MpuReportSize];
-        auto size = Controller.MakeMpuBuffer({data, 42});
-        Gamepad.sendReport(ReportMpu, data, size);
+        auto size = Controller.MakeMpuBuffer({data, sizeof(data)}, &timestamp);
+        const auto fields = Controller.GetMpuFields();
+        if (MpuFilter.IsDue({data, size}, fields, time))
+        {
+            // The filter always compares the half-float data, the host gets it in the format it selected
+            uint8_t report[MpuReportSize];
+            const auto length = MpuEncoding.Encode(Controller, {report, sizeof(report)});
+            if (Gamepad.sendReport(ReportMpu, report, length))
+            {
+                MpuFilter.Sent({data, size}, fields, time);
+                MpuEncoding.Sent();
+                if (size) Profile.AddLatency(Profiler::Stages::UsbMpuLatency, timestamp, LastMpuTimestamp);
+            }
+        }
+        LogUsb::Debug(", Sent ", GamepadFilter.GetSentCount() + MpuFilter.GetSentCount(),
+                      ", Suppressed ", GamepadFilter.GetSuppressedCount() + MpuFilter.GetSuppressedCount());
+    }
+    else if (!TinyUSBDevice.mounted())
+    {
+        GamepadFilter.Reset();
+        MpuFilter.Reset();
+        MpuEncoding.Reset();
     }
 
     LogUsb::Info(Tiny::TIEndl);
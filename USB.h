@@ -3,6 +3,9 @@
 #include "Config.h"
 #include "GamepadController.h"
 #include "CommandProcessor.h"
+#include "MpuEncoder.h"
+#include "Profiler.h"
+#include "ReportFilter.h"
 
 #include <Arduino.h>
 
@@ -14,7 +17,7 @@ namespace TinyCon
     class USBController
     {
     public:
-        USBController(const GamepadController&, CommandProcessor&) {}
+        USBController(const GamepadController&, CommandProcessor&, Profiler&) {}
 
         void Init() {}
         void Update() {}
@@ -36,22 +39,27 @@ namespace TinyCon
         };
 
     private:
-        static constexpr int16_t MpuReportSize = 21 * GamepadController::MaxMpuControllers;
+        // Only whole IMUs go into a report, the command processor refuses MPU data that leaves one out
+        static constexpr int16_t MpuReportSize = Tiny::Math::Min<int16_t, int16_t>(MpuEncoder::MaxSize, CommandProcessor::MaxMpuReportSize);
+        static constexpr uint16_t CommandReportSize = CommandProcessor::MaxCommandSize;
         static constexpr uint8_t HidDescriptor[] =
             {
                 TUD_HID_REPORT_DESC_GAMEPAD(HID_REPORT_ID(ReportGamepad)),
                 TUD_HID_REPORT_DESC_GENERIC_INOUT(MpuReportSize, HID_REPORT_ID(ReportMpu)),
-                TUD_HID_REPORT_DESC_GENERIC_INOUT(14, HID_REPORT_ID(ReportCommand))
+                TUD_HID_REPORT_DESC_GENERIC_INOUT(CommandReportSize, HID_REPORT_ID(ReportCommand))
             };
 
     public:
-        USBController(const GamepadController& controller, CommandProcessor& processor) : Controller(controller), Processor(processor) {}
+        USBController(const GamepadController& controller, CommandProcessor& processor, Profiler& profile)
+            : Controller(controller), Processor(processor), Profile(profile) {}
 
         void Init();
         void Update();
         void SetActive(bool active) { Active = active; }
         [[nodiscard]] bool IsActive() const { return Active; }
         [[nodiscard]] bool IsConnected() const { return Connected; }
+        [[nodiscard]] GamepadReportFilter& GetGamepadFilter() { return GamepadFilter; }
+        [[nodiscard]] MpuReportFilter& GetMpuFilter() { return MpuFilter; }
 
     private:
         static std::function<void(uint8_t, hid_report_type_t, const uint8_t*, uint16_t)> ReportReceived;
@@ -61,10 +69,17 @@ namespace TinyCon
 
         bool Active = false;
         bool Connected = false;
+        uint8_t RegisterAddress = 0;
+        uint32_t LastInputTimestamp = 0;
+        uint32_t LastMpuTimestamp = 0;
+        GamepadReportFilter GamepadFilter;
+        MpuReportFilter MpuFilter;
+        MpuEncoder MpuEncoding;
         Adafruit_USBD_HID Gamepad;
 
         const GamepadController& Controller;
         CommandProcessor& Processor;
+        Profiler& Profile;
     };
 #endif
 }
\ No newline at end of file
@@ -4,7 +4,9 @@
 
 #include "Core/Math/TIMath.h"
 
+#include <Arduino.h>
 #include <cstdint>
+#include <cstring>
 
 namespace TinyCon
 {
@@ -18,4 +20,40 @@ namespace TinyCon
         *data++ = half & 0xFF;
         *data++ = (half >> 8) & 0xFF;
     }
+
+    inline void FillInt16(uint8_t *&data, int16_t value)
+    {
+        *data++ = value & 0xFF;
+        *data++ = (value >> 8) & 0xFF;
+    }
+
+    inline void FillUInt32(uint8_t *&data, uint32_t value)
+    {
+        for (int8_t i = 0; i < 4; ++i) *data++ = (value >> (8 * i)) & 0xFF;
+    }
+
+    /** Half-float of a Q15 value without going through float, truncates to the 11 significant bits a half can hold */
+    constexpr uint16_t HalfFromQ15(int16_t value)
+    {
+        const uint16_t sign = value < 0 ? 0x8000 : 0;
+        const uint32_t magnitude = value < 0 ? -static_cast<int32_t>(value) : value;
+        if (!magnitude) return sign;
+        // The value is magnitude * 2^-15, so the position of the top bit is the biased half exponent as it is
+        const int msb = 31 - __builtin_clz(magnitude);
+        // 2^-15 is below the smallest normal half, it is the top bit of the subnormal mantissa
+        if (!msb) return sign | 0x200;
+        const uint32_t mantissa = msb >= 10 ? magnitude >> (msb - 10) : magnitude << (10 - msb);
+        return sign | msb << 10 | (mantissa & 0x3FF);
+    }
+
+    /** Float of a half as written by FillHalf, subnormals come out as zero since they are far below any sensor noise */
+    inline float FloatFromHalf(uint16_t half)
+    {
+        const uint32_t sign = static_cast<uint32_t>(half & 0x8000) << 16;
+        const uint32_t exponent = (half >> 10) & 0x1F;
+        const uint32_t bits = exponent ? sign | (exponent + 127 - 15) << 23 | static_cast<uint32_t>(half & 0x3FF) << 13 : sign;
+        float value;
+        memcpy(&value, &bits, sizeof(value));
+        return value;
+    }
 }
@@ -0,0 +1,54 @@
+#include "Wake.h"
+
+std::atomic<uint8_t> TinyCon::WakeController::Sources{0};
+std::atomic<uint32_t> TinyCon::WakeController::SignalTime{0};
+#if defined(NRF52840_XXAA) || defined(NRF52832_XXAA)
+SemaphoreHandle_t TinyCon::WakeController::Semaphore = nullptr;
+#endif
+
+void TinyCon::WakeController::Init()
+{
+#if defined(NRF52840_XXAA) || defined(NRF52832_XXAA)
+    if (!Semaphore) Semaphore = xSemaphoreCreateBinary();
+#endif
+    AwakeSince = micros();
+}
+
+void TinyCon::WakeController::Sleep(uint32_t time)
+{
+    const auto start = micros();
+    Profile.AddMicros(Profiler::Stages::Awake, start - AwakeSince);
+
+#if defined(NRF52840_XXAA) || defined(NRF52832_XXAA)
+    // The idle task puts the CPU to sleep while we block, same as delay(), but a signal ends the wait right away
+    const auto woken = xSemaphoreTake(Semaphore, pdMS_TO_TICKS(time)) == pdTRUE;
+#else
+    delay(time);
+    const auto woken = false;
+#endif
+
+    const auto end = micros();
+    Profile.AddMicros(Profiler::Stages::Sleep, end - start);
+    // A signal that arrived while we were busy leaves the semaphore given and only makes this sleep return at once,
+    // that is not a wake-up and would skew the latency.
+    const auto signalTime = SignalTime.load();
+    if (woken && static_cast<int32_t>(signalTime - start) >= 0) Profile.AddMicros(Profiler::Stages::WakeLatency, end - signalTime);
+    AwakeSince = end;
+}
+
+void TinyCon::WakeController::Signal(uint8_t source)
+{
+    SignalTime = micros();
+    Sources.fetch_or(source);
+
+#if defined(NRF52840_XXAA) || defined(NRF52832_XXAA)
+    if (!Semaphore) return;
+    if (__get_IPSR() != 0)
+    {
+        BaseType_t higherPriorityTaskWoken = pdFALSE;
+        xSemaphoreGiveFromISR(Semaphore, &higherPriorityTaskWoken);
+        portYIELD_FROM_ISR(higherPriorityTaskWoken);
+    }
+    else xSemaphoreGive(Semaphore);
+#endif
+}
@@ -0,0 +1,51 @@
+#pragma once
+
+#include "Config.h"
+
+#include "Profiler.h"
+
+#include <Arduino.h>
+
+#include <atomic>
+#include <cstdint>
+
+#if defined(NRF52840_XXAA) || defined(NRF52832_XXAA)
+#include <FreeRTOS.h>
+#include <semphr.h>
+#endif
+
+namespace TinyCon
+{
+    /**
+     * Sleeps between scheduler runs until the next task is due or a wake source is signalled, whichever comes first.
+     * Sources are signalled from interrupt context, the Seesaw INT lines, VBUS changing and the I2C slave being
+     * written to, so a suspended controller sleeps until something actually happens instead of polling over I2C.
+     * The wake latency and the time spent asleep and awake are recorded in the profiler.
+     */
+    class WakeController
+    {
+    public:
+        enum WakeSources : uint8_t { WakeInput = 1 << 0, WakePower = 1 << 1, WakeI2C = 1 << 2 };
+
+        explicit WakeController(Profiler& profile) : Profile(profile) {}
+
+        void Init();
+        /** Sleep for up to the given time in ms, returns early once a wake source is signalled */
+        void Sleep(uint32_t time);
+        /** Returns the sources signalled since the last call and clears them */
+        [[nodiscard]] uint8_t TakeSources() { return Sources.exchange(0); }
+
+        /** Safe to call from interrupt context */
+        static void Signal(uint8_t source);
+
+    private:
+        Profiler& Profile;
+        uint32_t AwakeSince = 0;
+
+        static std::atomic<uint8_t> Sources;
+        static std::atomic<uint32_t> SignalTime;
+    #if defined(NRF52840_XXAA) || defined(NRF52832_XXAA)
+        static SemaphoreHandle_t Semaphore;
+    #endif
+    };
+}